@@ -7,6 +7,17 @@
  * all implemntation is of my own. This library is not intented for security
  * usage such as crytography. Use at your own risk.
  *
+ * Functions never write the value of the BigInts they only read, so any
+ * number of threads may share an operand. Two fields of an operand are
+ * written behind the caller, both atomically: bigint_copy() and the
+ * functions sharing digits like it (bigint_abs(), bigint_neg() and the
+ * cache lookups) install a sharer count on a heap operand the first time
+ * it is copied, kept until the operand is written or freed, and
+ * bigint_to_str() and bigint_num_digits() remember the decimal length
+ * they found. A BigInt being written, the dst of a destination variant
+ * or the argument of bigint_reserve(), bigint_shrink_to_fit() or
+ * bigint_free(), must not be used by other threads meanwhile.
+ *
  * @author Vincent Mai
  * @version 0.5.0
  */
@@ -15,8 +26,144 @@
 #define BIGINT_H
 
 #include <stdint.h>
+#include <stddef.h>
 
 typedef struct BigInt BigInt;
+typedef struct BigIntModCtx BigIntModCtx;
+typedef struct BigIntCache BigIntCache;
+
+/* Public functions counted by the statistics, see bigint_stats_snapshot */
+enum BigIntOp
+{
+    BIGINT_OP_INIT,
+    BIGINT_OP_INT_INIT,
+    BIGINT_OP_FIXED_INIT,
+    BIGINT_OP_TO_STR,
+    BIGINT_OP_NUM_DIGITS,
+    BIGINT_OP_ADD,
+    BIGINT_OP_SUBTR,
+    BIGINT_OP_MULT,
+    BIGINT_OP_SQR,
+    BIGINT_OP_DIV,
+    BIGINT_OP_MOD,
+    BIGINT_OP_LOG,
+    BIGINT_OP_POWER_MOD,
+    BIGINT_OP_ADD_TO,
+    BIGINT_OP_SUBTR_TO,
+    BIGINT_OP_MULT_TO,
+    BIGINT_OP_DIV_TO,
+    BIGINT_OP_MOD_TO,
+    BIGINT_OP_POWER_MOD_TO,
+    BIGINT_OP_MODCTX_INIT,
+    BIGINT_OP_MOD_CTX,
+    BIGINT_OP_MULMOD_CTX,
+    BIGINT_OP_POWMOD_CTX,
+    BIGINT_OP_MODCTX_FREE,
+    BIGINT_OP_CACHE_INIT,
+    BIGINT_OP_CACHE_DIV,
+    BIGINT_OP_CACHE_MOD,
+    BIGINT_OP_CACHE_POWER_MOD,
+    BIGINT_OP_CACHE_TO_STR,
+    BIGINT_OP_CACHE_STATS,
+    BIGINT_OP_CACHE_CLEAR,
+    BIGINT_OP_CACHE_FREE,
+    BIGINT_OP_ABS,
+    BIGINT_OP_NEG,
+    BIGINT_OP_ST,
+    BIGINT_OP_GT,
+    BIGINT_OP_EQ,
+    BIGINT_OP_COPY,
+    BIGINT_OP_REF,
+    BIGINT_OP_UNREF,
+    BIGINT_OP_RESERVE,
+    BIGINT_OP_SHRINK_TO_FIT,
+    BIGINT_OP_SET_ALLOCATOR,
+    BIGINT_OP_SCRATCH_RELEASE,
+    BIGINT_OP_POOL_OCCUPANCY,
+    BIGINT_OP_POOL_TRIM,
+    BIGINT_OP_HASH,
+    BIGINT_OP_HASH64,
+    BIGINT_OP_HASH_BULK,
+    BIGINT_OP_FREE,
+    BIGINT_OPS
+};
+
+/**
+ * struct BigIntOpStats - counters of a public function.
+ *
+ * @calls The number of calls made by the application.
+ * @limbs The total limbs of their operands (9 digit chunks of the string
+ *        for bigint_init, 0 for functions without digit operands).
+ * @nanos The total time spent in them, only kept for the arithmetic,
+ *        conversions and cached operations. The other functions are too
+ *        cheap to time and only counted.
+ */
+typedef struct BigIntOpStats
+{
+    uint64_t calls;
+    uint64_t limbs;
+    uint64_t nanos;
+} BigIntOpStats;
+
+/**
+ * struct BigIntStats - counters of a library built with BIGINT_STATS.
+ *
+ * @ops The counters of each public function, indexed by enum BigIntOp.
+ * @mallocs The number of allocations.
+ * @reallocs The number of reallocations, whether they moved or not.
+ * @frees The number of frees.
+ * @bytes_live The bytes allocated and not freed yet, strings returned by
+ *             bigint_to_str excepted since the caller frees them.
+ * @bytes_peak The highest bytes_live since the last reset.
+ */
+typedef struct BigIntStats
+{
+    BigIntOpStats ops[BIGINT_OPS];
+    uint64_t mallocs;
+    uint64_t reallocs;
+    uint64_t frees;
+    uint64_t bytes_live;
+    uint64_t bytes_peak;
+} BigIntStats;
+
+/* Opts an operation into a BigIntCache, see bigint_cache_init */
+#define BIGINT_CACHE_OP(op) (1ull << (op))
+
+/**
+ * struct BigIntCacheStats - counters of a BigIntCache.
+ *
+ * @hits The calls answered by a remembered result.
+ * @misses The calls of cached operations that computed their result.
+ * @evictions The results dropped to stay within the budget.
+ * @entries The number of results remembered.
+ * @bytes The bytes held by the entries, their operands included, and by
+ *        the hash table of the cache.
+ */
+typedef struct BigIntCacheStats
+{
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t entries;
+    uint64_t bytes;
+} BigIntCacheStats;
+
+/* Upper bound of sizeof(struct BigInt), the handle without its digits */
+#define BIGINT_HANDLE_SIZE 48
+
+/* 64bit words of storage for a fixed BigInt of the given limbs, 1 or more */
+#define BIGINT_FIXED_WORDS(limbs) \
+    ((BIGINT_HANDLE_SIZE + ((limbs) + 1) * sizeof(uint32_t) + 7) / 8)
+
+/*
+ * Declares name as a BigInt of at most limbs limbs, zero initially, whose
+ * handle and digits live in an automatic array, see bigint_fixed_init.
+ * Inside a struct, declare uint64_t storage[BIGINT_FIXED_WORDS(limbs)]
+ * and pass it to bigint_fixed_init instead.
+ */
+#define BIGINT_FIXED(name, limbs)                                           \
+    uint64_t name##_storage[BIGINT_FIXED_WORDS(limbs)];                     \
+    BigInt* name = bigint_fixed_init(name##_storage, (limbs))
 
 /**
  * @brief Initializes a BigInt by a string.
@@ -29,11 +176,32 @@ BigInt* bigint_init(char* sn);
 /**
  * @brief Initializes a BigInt by an integer.
  *
+ * Values of up to two limbs are stored inside the handle, so the
+ * result is a writable BigInt that needs no digit allocation, e.g. a
+ * zero accumulator for the destination variants.
+ *
  * @param n An integer to 
  * @return A pointer to the initialized BigInt.
  */
 BigInt* bigint_int_init(int32_t n);
 
+/**
+ * @brief Initializes a zero BigInt of fixed capacity in caller storage.
+ *
+ * The handle and its digits live in storage, nothing is allocated.
+ * The BigInt can be read by any function and written by the destination
+ * variants, e.g. bigint_add_to(), which never allocate for it. A result
+ * of more than limbs limbs is an error. bigint_free only forgets the
+ * pointer and bigint_copy returns a heap copy, the storage stays with
+ * the caller and must outlive every use of the BigInt.
+ *
+ * @param storage At least BIGINT_FIXED_WORDS(limbs) words.
+ * @param limbs The capacity in limbs, 9 decimal digits each (32 bits when
+ *              built with BIGINT_BINARY_LIMBS), at least 1.
+ * @return A pointer to the BigInt, inside storage, or NULL if limbs is 0.
+ */
+BigInt* bigint_fixed_init(uint64_t* storage, uint32_t limbs);
+
 /**
  * @brief Converts a BigInt to string.
  *
@@ -42,6 +210,17 @@ BigInt* bigint_int_init(int32_t n);
  */
 char* bigint_to_str(BigInt* n);
 
+/**
+ * @brief Counts the decimal digits of a BigInt, without its sign.
+ *
+ * The count is cached in n, it is only computed on the first call
+ * (or by bigint_to_str).
+ *
+ * @param n A BigInt.
+ * @return The number of decimal digits of n.
+ */
+uint32_t bigint_num_digits(BigInt* n);
+
 /**
  * @brief Sums a and b.
  *
@@ -69,6 +248,16 @@ BigInt* bigint_subtr(BigInt* a, BigInt* b);
  */
 BigInt* bigint_mult(BigInt* a, BigInt* b);
 
+/**
+ * @brief Squares n.
+ *
+ * Equivalent to bigint_mult(n, n), which also detects equal operands.
+ *
+ * @param n A large integer as a BigInt.
+ * @return A pointer to the square as a BigInt.
+ */
+BigInt* bigint_sqr(BigInt* n);
+
 /**
  * @brief Divides n by d.
  *
@@ -119,9 +308,215 @@ BigInt* bigint_log(BigInt* n, BigInt* b);
  */
 BigInt* bigint_power_mod (BigInt* b, BigInt* e, BigInt* m);
 
+/**
+ * @brief Sums a and b into dst.
+ *
+ * The destination variants below compute the same results as their
+ * allocating counterparts, but write them to an existing BigInt whose
+ * digit buffer is reused when it is large enough. Only dst is written,
+ * the operands are const. dst may alias any operand, e.g.
+ * bigint_add_to(acc, acc, x).
+ *
+ * @param dst The BigInt receiving the sum.
+ * @param a A large integer as a BigInt.
+ * @param b A large integer as a BigInt.
+ */
+void bigint_add_to(BigInt* dst, const BigInt* a, const BigInt* b);
+
+/**
+ * @brief Subtracts b from a into dst, see bigint_add_to().
+ *
+ * @param dst The BigInt receiving the difference.
+ * @param a A large integer as a BigInt.
+ * @param b A large integer as a BigInt.
+ */
+void bigint_subtr_to(BigInt* dst, const BigInt* a, const BigInt* b);
+
+/**
+ * @brief Multiplies a and b into dst, see bigint_add_to().
+ *
+ * @param dst The BigInt receiving the product.
+ * @param a A large integer as a BigInt.
+ * @param b A large integer as a BigInt.
+ */
+void bigint_mult_to(BigInt* dst, const BigInt* a, const BigInt* b);
+
+/**
+ * @brief Divides n by d into dst like bigint_div(), see bigint_add_to().
+ *
+ * @param dst The BigInt receiving the quotian.
+ * @param n The divident as a BigInt.
+ * @param d The divisor as a BigInt.
+ */
+void bigint_div_to(BigInt* dst, const BigInt* n, const BigInt* d);
+
+/**
+ * @brief Computes n modulo m into dst like bigint_mod(), see
+ * bigint_add_to().
+ *
+ * @param dst The BigInt receiving the remainder.
+ * @param n The divident as a BigInt.
+ * @param m The divisor as a BigInt.
+ */
+void bigint_mod_to(BigInt* dst, const BigInt* n, const BigInt* m);
+
+/**
+ * @brief Computes (b raised to e) modulo m into dst like
+ * bigint_power_mod(), see bigint_add_to().
+ *
+ * @param dst The BigInt receiving the remainder.
+ * @param b The base as a BigInt.
+ * @param e The exponent as a BigInt.
+ * @param m The divisor as a BigInt.
+ */
+void bigint_power_mod_to(BigInt* dst, const BigInt* b, const BigInt* e,
+                         const BigInt* m);
+
+/**
+ * @brief Precomputes the reduction constants of a modulus.
+ *
+ * The context serves any number of bigint_mod_ctx(),
+ * bigint_mulmod_ctx() and bigint_powmod_ctx() calls against m, which
+ * then skip the per-call setup. It keeps its own copy of m and is not
+ * modified by those calls.
+ *
+ * @param m The nonzero divisor as a BigInt.
+ * @return A pointer to the context, released by bigint_modctx_free().
+ */
+BigIntModCtx* bigint_modctx_init(BigInt* m);
+
+/**
+ * @brief Computes n modulo the modulus of ctx, like bigint_mod().
+ *
+ * @param n The divident as a BigInt.
+ * @param ctx A context from bigint_modctx_init().
+ * @return A pointer to the remainder as a BigInt.
+ */
+BigInt* bigint_mod_ctx(BigInt* n, BigIntModCtx* ctx);
+
+/**
+ * @brief Computes (a * b) modulo the modulus of ctx, like bigint_mod().
+ *
+ * @param a A large integer as a BigInt.
+ * @param b A large integer as a BigInt.
+ * @param ctx A context from bigint_modctx_init().
+ * @return A pointer to the remainder as a BigInt.
+ */
+BigInt* bigint_mulmod_ctx(BigInt* a, BigInt* b, BigIntModCtx* ctx);
+
+/**
+ * @brief Computes (b raised to e) modulo the modulus of ctx, like
+ * bigint_power_mod().
+ *
+ * @param b The base as a BigInt.
+ * @param e The exponent as a BigInt.
+ * @param ctx A context from bigint_modctx_init().
+ * @return A pointer to the remainder as a BigInt.
+ */
+BigInt* bigint_powmod_ctx(BigInt* b, BigInt* e, BigIntModCtx* ctx);
+
+/**
+ * @brief Frees a modulus context.
+ *
+ * @param ctx The address of a BigIntModCtx pointer.
+ */
+void bigint_modctx_free(BigIntModCtx** ctx);
+
+/**
+ * @brief Creates a cache for the results of expensive operations.
+ *
+ * bigint_cache_div(), bigint_cache_mod(), bigint_cache_power_mod() and
+ * bigint_cache_to_str() remember their results by the operation and the
+ * operand values, so a later call on equal operands is a table lookup.
+ * The cache holds copies of the operands and results, up to budget
+ * bytes, and drops the least recently used results to make room. Calls
+ * of operations left out of ops are computed without the cache. Every
+ * call updates the cache, so a cache must not be used by several
+ * threads at once.
+ *
+ * @param budget The most bytes the entries and their hash table may hold.
+ * @param ops The operations to cache, e.g.
+ *            BIGINT_CACHE_OP(BIGINT_OP_DIV) | BIGINT_CACHE_OP(BIGINT_OP_TO_STR)
+ *            for bigint_cache_div() and bigint_cache_to_str().
+ * @return A pointer to the cache, released by bigint_cache_free().
+ */
+BigIntCache* bigint_cache_init(size_t budget, uint64_t ops);
+
+/**
+ * @brief Divides n by d like bigint_div(), through cache.
+ *
+ * The result shares its digits with the remembered one like
+ * bigint_copy(), and is freed by the caller as usual.
+ *
+ * @param cache A cache from bigint_cache_init().
+ * @param n The divident as a BigInt.
+ * @param d The divisor as a BigInt.
+ * @return A pointer to the quotian as a BigInt.
+ */
+BigInt* bigint_cache_div(BigIntCache* cache, BigInt* n, BigInt* d);
+
+/**
+ * @brief Computes n modulo m like bigint_mod(), through cache.
+ *
+ * @param cache A cache from bigint_cache_init().
+ * @param n The divident as a BigInt.
+ * @param m The divisor as a BigInt.
+ * @return A pointer to the remainder as a BigInt.
+ */
+BigInt* bigint_cache_mod(BigIntCache* cache, BigInt* n, BigInt* m);
+
+/**
+ * @brief Computes (b raised to e) modulo m like bigint_power_mod(),
+ * through cache.
+ *
+ * @param cache A cache from bigint_cache_init().
+ * @param b The base as a BigInt.
+ * @param e The exponent as a BigInt.
+ * @param m The divisor as a BigInt.
+ * @return A pointer to the remainder as a BigInt.
+ */
+BigInt* bigint_cache_power_mod(BigIntCache* cache, BigInt* b, BigInt* e,
+                               BigInt* m);
+
+/**
+ * @brief Converts a BigInt to string like bigint_to_str(), through cache.
+ *
+ * @param cache A cache from bigint_cache_init().
+ * @param n A BigInt to be converted to string.
+ * @return The string representation of the BigInt, freed by the caller.
+ */
+char* bigint_cache_to_str(BigIntCache* cache, BigInt* n);
+
+/**
+ * @brief Reads the counters of a cache.
+ *
+ * @param cache A cache from bigint_cache_init().
+ * @return A copy of the counters.
+ */
+BigIntCacheStats bigint_cache_stats(BigIntCache* cache);
+
+/**
+ * @brief Drops every result of a cache, its counters excepted.
+ *
+ * The hash table keeps its slots, and bytes keeps counting them.
+ *
+ * @param cache A cache from bigint_cache_init().
+ */
+void bigint_cache_clear(BigIntCache* cache);
+
+/**
+ * @brief Frees a cache with its results.
+ *
+ * @param cache The address of a BigIntCache pointer.
+ */
+void bigint_cache_free(BigIntCache** cache);
+
 /**
  * @brief Returns the absolute value of n
  *
+ * The result shares the digits of n like bigint_copy(), the
+ * value of n is not written.
+ *
  * @param n A large integer as a BigInt.
  * @return A pointer to the absolute value of n as a BigInt.
  */
@@ -130,6 +525,9 @@ BigInt* bigint_abs(BigInt* n);
 /**
  * @brief Negates the sign of n
  *
+ * The result shares the digits of n like bigint_copy(), the
+ * value of n is not written.
+ *
  * @param n A large integer as a BigInt.
  * @return A pointer to the negated n as a BigInt.
  */
@@ -165,26 +563,177 @@ int bigint_eq(BigInt* a, BigInt* b);
 /**
  * @brief Returns a copy of an BigInt.
  *
+ * The copy shares the digits of n until either of them is written by a
+ * destination variant, which clones them first, so copying takes O(1).
+ * The first copy of n with heap digits allocates their sharer count and
+ * stores it in n, the only write to n, made atomically, which is why n
+ * is not const.
+ *
  * @param n Large integer stored as a BigInt.
  * @return A pointer to the copy of n.
  */
 BigInt* bigint_copy(BigInt* n);
 
+/**
+ * @brief Takes a reference to n.
+ *
+ * The handle stays valid until every reference has been released by
+ * bigint_unref() or bigint_free(). All references see the same value,
+ * a write through one of them is seen by all, unlike bigint_copy().
+ *
+ * @param n Large integer stored as a BigInt.
+ * @return n.
+ */
+BigInt* bigint_ref(BigInt* n);
+
+/**
+ * @brief Releases a reference to a BigInt, freeing it with the last one.
+ *
+ * @param n The address of a BigInt pointer, set to NULL.
+ */
+void bigint_unref(BigInt** n);
+
+/**
+ * @brief Makes room for at least limbs digits in n.
+ *
+ * A limb holds 9 decimal digits (32 bits when built with
+ * BIGINT_BINARY_LIMBS). Results written to n by the destination
+ * variants, e.g. bigint_add_to(), reuse the room instead of
+ * reallocating. Buffers also grow geometrically on their own, so this
+ * only saves the first few reallocations of a long-lived accumulator.
+ *
+ * @param n A large integer as a BigInt.
+ * @param limbs The number of limbs to make room for.
+ */
+void bigint_reserve(BigInt* n, size_t limbs);
+
+/**
+ * @brief Releases the spare room of the digit buffer of n.
+ *
+ * @param n A large integer as a BigInt.
+ */
+void bigint_shrink_to_fit(BigInt* n);
+
+/**
+ * @brief Replaces the allocator of the library.
+ *
+ * Every allocation of the library comes from malloc_fn and goes back
+ * through free_fn: digit buffers, BigInts, strings, contexts, and result
+ * caches with their hash tables. Strings returned by bigint_to_str and
+ * bigint_cache_to_str must therefore be released with free_fn.
+ * Temporaries of the arithmetic come from a per-thread arena, itself
+ * refilled by malloc_fn. NULL restores the C allocator. Only HashMaps
+ * created by the user directly, see hashmap.h, keep the C allocator.
+ *
+ * Call it while no other thread is inside the library, and after freeing
+ * the BigInts, strings and contexts of the previous allocator. The arena
+ * and pool of each thread are handed back to the allocator they came
+ * from, those of the calling thread at once and those of other threads
+ * on their next call.
+ *
+ * @param malloc_fn Replacement for malloc.
+ * @param realloc_fn Replacement for realloc.
+ * @param free_fn Replacement for free.
+ */
+void bigint_set_allocator(void* (*malloc_fn)(size_t),
+                          void* (*realloc_fn)(void*, size_t),
+                          void (*free_fn)(void*));
+
+/**
+ * @brief Returns the temporary arena of the calling thread to the allocator.
+ *
+ * The arena keeps its memory between operations, call this before a
+ * thread exits or after an unusually large operation.
+ */
+void bigint_scratch_release();
+
+/**
+ * @brief Reports the digit buffers cached by the pool of the calling thread.
+ *
+ * Digit buffers of up to 16 KiB come in power of two size classes, the
+ * buffers of freed BigInts are kept per thread for the next result of
+ * the same class.
+ *
+ * @param buffers Receives the number of cached buffers, may be NULL.
+ * @return The number of bytes held by the cached buffers.
+ */
+size_t bigint_pool_occupancy(size_t* buffers);
+
+/**
+ * @brief Returns the buffers cached by the pool of the calling thread to
+ * the allocator.
+ *
+ * Call it before a thread exits, or after freeing many BigInts that will
+ * not be replaced.
+ */
+void bigint_pool_trim();
+
+/**
+ * @brief Reads the statistics of the library.
+ *
+ * The counters are only kept when the library is built with
+ * -DBIGINT_STATS, they stay zero otherwise. Counters are shared by all
+ * threads and read one at a time, so a snapshot taken during concurrent
+ * calls may be slightly skewed.
+ *
+ * @return A copy of the counters.
+ */
+BigIntStats bigint_stats_snapshot();
+
+/**
+ * @brief Zeroes the counters, bytes_live excepted.
+ *
+ * bytes_peak restarts from bytes_live.
+ */
+void bigint_stats_reset();
+
+/**
+ * @brief Names an operation of the statistics, e.g. "mult_to".
+ *
+ * @param op An enum BigIntOp.
+ * @return The name of the public function without its bigint_ prefix.
+ */
+const char* bigint_stats_name(int op);
+
 /**
  * @brief Returns a 32bit hash code of the input BigInt.
  *
  * This hash function is designed to be used by a hashmap-like data
  * structure. The void pointer arguments is defined such that the 
  * caller data structure can be decoupled from the type BigInt.
+ * It folds bigint_hash64() to 32 bits, n is not written although the
+ * hashmap callback type leaves it non-const.
  *
  * @param n Large integer stored as a BigInt.
  * @return A 32bit hash code.
  */
 uint32_t bigint_hash(void* n);
 
+/**
+ * @brief Returns a 64bit hash code of the input BigInt.
+ *
+ * Equal values hash equally however they are stored. Hashes depend on
+ * the limb base, builds with and without BIGINT_BINARY_LIMBS differ.
+ *
+ * @param n Large integer stored as a BigInt.
+ * @return A 64bit hash code.
+ */
+uint64_t bigint_hash64(const BigInt* n);
+
+/**
+ * @brief Computes bigint_hash64() of count BigInts.
+ *
+ * @param ns An array of count BigInts.
+ * @param count The number of BigInts.
+ * @param hashes Receives the count hash codes.
+ */
+void bigint_hash_bulk(BigInt** ns, size_t count, uint64_t* hashes);
+
 /**
  * @brief Frees the allocated heap memory.
  *
+ * Same as bigint_unref(), a BigInt with other references outlives it.
+ *
  * @param n The address of a BigInt pointer.
  */
 void bigint_free(BigInt** n);
@@ -12,30 +12,85 @@
 #define INT_BIGINT_H
 
 #include <stdio.h>
-#include <hashmap.h>
 #include <stdint.h>
 
 /**
  * struct BigInt - stores big integer
  * 
- * Big integers are represented with Base-giga digits.
+ * Big integers are represented with Base-giga digits, or base 2^32 digits
+ * when built with BIGINT_BINARY_LIMBS, and a separate sign.
  * Inspired by CPython Bignum (PEP 237), which stores
  * big numbers in Base-30-bit.
  *
- * @sign_len Stores the sign and number of decimal digits.
- * @digits Stores the digits in Base-giga in little-endian order.
+ * The struct is a handle: the digits live inline in small until the value
+ * outgrows it, then in a heap buffer that copies may share, or in caller
+ * storage for a fixed BigInt, see bigint_fixed_init.
+ *
+ * @sign Stores the sign, 1 or -1, zero is positive.
+ * @len_dec Caches the number of decimal digits, 0 until computed by
+ *          bigint_num_digits or bigint_to_str.
+ * @digits Stores the digits in Base-giga (base 2^32 when built with
+ *         BIGINT_BINARY_LIMBS) in little-endian order, the limb count
+ *         at index 0.
+ * @cap Stores the number of limbs the digit buffer has room for, not
+ *      counting the limb count at index 0.
+ * @refs Counts the references to the handle, see bigint_ref.
+ * @shared Counts the BigInts sharing the digit buffer, NULL while it has
+ *         a single owner. Writers clone a shared buffer first. Points to
+ *         a marker instead when the digits are borrowed caller storage.
+ * @small Inline digit buffer, digits points here until the value
+ *        outgrows INLINE_LIMBS limbs, so small values need no allocation.
  */
 
 typedef struct BigInt BigInt;
 
+/* Limbs stored inside struct BigInt before the digits move to the heap */
+#define INLINE_LIMBS 2
+
 struct BigInt
 {
-    int32_t sign_len;
+    int32_t sign;
+    uint32_t len_dec;
     uint32_t* digits;
+    uint32_t cap;
+    uint32_t refs;
+    uint32_t* shared;
+    uint32_t small[INLINE_LIMBS + 1];
 };
 
 /** internal uses */
-BigInt* _neg(BigInt* n); // TODO: do this without using BigInt.
+BigInt* _wrap(uint32_t* digits, int32_t sign);
+BigInt* _alloc();
+BigInt* _new();
+void _unshare(BigInt* n);
+void _move(BigInt* dst, BigInt* src);
+void _assign(BigInt* dst, BigInt* src);
+void _borrow(BigInt* n, uint32_t* digits, uint32_t cap);
+void _set_result(BigInt* n, int32_t sign);
+void _init_inline(BigInt* n);
+void _adopt(BigInt* n, uint32_t* digits);
+void _free_digits(BigInt* n);
+int _is_inline(BigInt* n);
+int _is_borrowed(BigInt* n);
+int __both_small(const BigInt* a, const BigInt* b);
+uint64_t __small_value(uint32_t* digits);
+uint64_t __hash_value(const BigInt* n);
+uint64_t __hash_mum(uint64_t a, uint64_t b);
+uint64_t __hash_limbs(uint32_t* limbs, uint32_t len, uint64_t seed);
+void __divmod_small(BigInt* q, BigInt* r, const BigInt* n, const BigInt* d);
+uint32_t* __scratch(size_t len);
+uint32_t* __scratch_zero(size_t len);
+void __scratch_free(uint32_t* span);
+void __scratch_release();
+size_t __pool_size(size_t words);
+uint32_t* __pool_get(size_t words);
+void __pool_put(uint32_t* digits, size_t words);
+void __free_digits(uint32_t* digits);
+void __reserve_digits(BigInt* n, uint32_t len);
+void __resize_digits(BigInt* n, uint32_t cap);
+void __add_signed_to(BigInt* dst, const BigInt* a, const BigInt* b,
+                     int32_t sign_b);
+void __divmod_to(BigInt* q, BigInt* r, const BigInt* n, const BigInt* d);
 
 /**
  * struct QuoRem - stores a quotian and a remainder.
@@ -53,6 +108,56 @@ struct QuoRem
     uint32_t* remainder;
 };
 
+/**
+ * struct BigIntModCtx - precomputed state for arithmetic modulo m.
+ *
+ * Residues are spans of exactly len limbs. For a modulus coprime to
+ * BASE they are kept in Montgomery form a * R mod m with R = BASE^len,
+ * otherwise they are plain and every product is reduced by Barrett.
+ * The context is never written after initialization.
+ *
+ * @m The modulus as a limb span.
+ * @len The number of limbs of m.
+ * @sign The sign of the modulus, 1 or -1.
+ * @m_inv -m^-1 modulo BASE, 0 when m is not coprime to BASE.
+ * @one The residue of 1.
+ * @mu The Barrett constant floor(BASE^(2 len) / m).
+ * @len_mu The number of limbs of mu, 0 when mu is not computed.
+ */
+struct BigIntModCtx
+{
+    uint32_t* m;
+    uint32_t len;
+    int32_t sign;
+    uint32_t m_inv;
+    uint32_t* one;
+    uint32_t* mu;
+    uint32_t len_mu;
+};
+
+/**
+ * struct NttPrime - Montgomery constants of one NTT prime.
+ *
+ * @p The prime modulus.
+ * @p_inv -p^-1 modulo 2^32.
+ * @r2 2^64 modulo p, converts into Montgomery form.
+ */
+struct NttPrime
+{
+    uint32_t p;
+    uint32_t p_inv;
+    uint32_t r2;
+};
+
+/* multiplication tuning */
+extern uint32_t __karatsuba_threshold;
+extern uint32_t __toom3_threshold;
+extern uint32_t __toom4_threshold;
+extern uint32_t __ntt_threshold;
+
+/* division tuning */
+extern uint32_t __div_dc_threshold;
+
 /* private functions */
 int __same_sign(BigInt* a, BigInt* b);
 int __is_zero(uint32_t* n);
@@ -60,25 +165,90 @@ int __is_one(uint32_t* n);
 int __gt(uint32_t* a, uint32_t* b);
 int __st(uint32_t* a, uint32_t* b);
 int __eq(uint32_t* a, uint32_t* b);
-int __cmp_key(void* a, void* b);
-void __incr(uint32_t* n);
+uint32_t* __incr(uint32_t* n);
 void __decr(uint32_t* n);
-char* __repr_keyval(void* key);
 uint32_t __to_decimal(uint32_t* n);
 uint32_t __len_decimal(uint32_t* digits);
-uint32_t __hash_digits(void* key);
 uint32_t* __to_base_giga(char* sn, int32_t len);
+#ifdef BIGINT_BINARY_LIMBS
+uint32_t* __giga_to_limbs(uint32_t* giga);
+uint32_t* __limbs_to_giga(uint32_t* n);
+uint32_t** __giga_powers(uint32_t len);
+void __giga_powers_free(uint32_t** pw);
+uint32_t __giga_to_limbs_dc(uint32_t* res, uint32_t* g, uint32_t len,
+                            uint32_t** pw);
+void __limbs_to_giga_dc(uint32_t* g, uint32_t len_g, uint32_t* n,
+                        uint32_t len, uint32_t** pw);
+#endif
 uint32_t* __arg_len_max(uint32_t* a, uint32_t* b);
 uint32_t* __arg_len_min(uint32_t* a, uint32_t* b);
 uint32_t* __assign_digits(uint32_t n);
 uint32_t* __copy_digits(uint32_t* n);
 uint32_t* __right_shift(uint32_t* n);
 uint32_t* __mult(uint32_t* a, uint32_t* b);
+uint32_t __add_limbs(uint32_t* res, uint32_t* a, uint32_t len_a,
+                     uint32_t* b, uint32_t len_b);
+uint32_t __subtr_limbs(uint32_t* res, uint32_t* a, uint32_t len_a,
+                       uint32_t* b, uint32_t len_b);
+void __mult_limbs(uint32_t* res, uint32_t* a, uint32_t len_a,
+                  uint32_t* b, uint32_t len_b);
+void __mult_school(uint32_t* res, uint32_t* a, uint32_t len_a,
+                   uint32_t* b, uint32_t len_b);
+void __sqr_school(uint32_t* res, uint32_t* a, uint32_t len);
+void __mult_karatsuba(uint32_t* res, uint32_t* a, uint32_t len_a,
+                      uint32_t* b, uint32_t len_b);
+void __mult_chunked(uint32_t* res, uint32_t* a, uint32_t len_a,
+                    uint32_t* b, uint32_t len_b);
+void __mult_toom(uint32_t* res, uint32_t* a, uint32_t len_a,
+                 uint32_t* b, uint32_t len_b, uint32_t k_a, uint32_t k_b);
+void __toom_eval(uint32_t* res, int* signs, uint32_t* a, uint32_t len_a,
+                 uint32_t len_part, uint32_t k, uint32_t n_points);
+void __mult_ntt(uint32_t* res, uint32_t* a, uint32_t len_a,
+                uint32_t* b, uint32_t len_b);
+void __ntt_init_prime(struct NttPrime* np, uint32_t p);
+uint32_t __ntt_mul(struct NttPrime* np, uint32_t a, uint32_t b);
+uint32_t __ntt_pow(struct NttPrime* np, uint32_t a, uint64_t e);
+void __ntt(struct NttPrime* np, uint32_t* f, uint32_t len, int inverse);
+void __ntt_convolve(struct NttPrime* np, uint32_t* res, uint32_t* a,
+                    uint32_t len_a, uint32_t* b, uint32_t len_b,
+                    uint32_t len);
+uint32_t __addmul_limbs(uint32_t* res, uint32_t len_res,
+                        uint32_t* a, uint32_t len_a, uint32_t m);
+uint32_t __submul_limbs(uint32_t* res, uint32_t* a, uint32_t len_a,
+                        uint32_t m);
+uint32_t __divmod_limb(uint32_t* q, uint32_t* n, uint32_t len, uint32_t d);
+void __divmod_limbs(uint32_t* q, uint32_t* r, uint32_t* n, uint32_t len_n,
+                    uint32_t* d, uint32_t len_d);
+void __divmod_school(uint32_t* q, uint32_t* u, uint32_t len_q,
+                     uint32_t* d, uint32_t len_d);
+void __divmod_dc(uint32_t* q, uint32_t* u, uint32_t len_q,
+                 uint32_t* d, uint32_t len_d);
+void __divexact_limbs(uint32_t* n, uint32_t len, uint32_t d);
+int __cmp_limbs(uint32_t* a, uint32_t* b, uint32_t len);
+uint32_t __trim_limbs(uint32_t* n, uint32_t len);
 uint32_t* __add(uint32_t* a, uint32_t* b);
 uint32_t* __subtr(uint32_t* a, uint32_t* b);
 uint32_t* __slice_digits(uint32_t* n, int start, int end);
-uint32_t* __power_mod(uint32_t* base, uint32_t* exp,
-                     uint32_t* m, HashMap* cache);
+uint32_t* __power_mod(uint32_t* base, uint32_t* exp, uint32_t* m);
+struct BigIntModCtx* __modctx_init(uint32_t* m, int barrett);
+void __modctx_free(struct BigIntModCtx** ctx);
+void __modctx_to(struct BigIntModCtx* ctx, uint32_t* res, uint32_t* n);
+void __modctx_reduce(struct BigIntModCtx* ctx, uint32_t* res, uint32_t* n,
+                     uint32_t len_n);
+BigInt* __modctx_signed(struct BigIntModCtx* ctx, uint32_t* rem,
+                        int positive);
+void __barrett(struct BigIntModCtx* ctx, uint32_t* res, uint32_t* x,
+               uint32_t* tmp);
+uint32_t* __modctx_from(struct BigIntModCtx* ctx, uint32_t* a);
+void __modctx_mul(struct BigIntModCtx* ctx, uint32_t* res, uint32_t* a,
+                  uint32_t* b, uint32_t* tmp);
+uint32_t* __modctx_pow(struct BigIntModCtx* ctx, uint32_t* base, uint32_t* exp);
+uint32_t __mont_inv(uint32_t m0);
+void __mont_mul(uint32_t* res, uint32_t* a, uint32_t* b, uint32_t* m,
+                uint32_t len, uint32_t m_inv, uint32_t* t);
+void __mont_redc(uint32_t* res, uint32_t* t, uint32_t* m, uint32_t len,
+                 uint32_t m_inv, uint32_t* u);
+uint32_t* __to_base_bits(uint32_t* n, uint32_t* n_bits);
 uint32_t** __divmod(uint32_t* n, uint32_t* m);
 struct QuoRem* __single_divmod(uint32_t* n, uint32_t* d);
 
@@ -0,0 +1,116 @@
+/**
+ * @brief This file contains function prototypes of a generic hashmap that
+ *        may be shared by threads.
+ *
+ * The hashmap is split into shards, each a HashMap guarded by its own
+ * read-write lock, so threads working on different shards never wait for
+ * each other and readers of one shard proceed together. Keys are spread
+ * over the shards by their hash. The user functions are the same as for
+ * a HashMap, see hashmap.h, and may be called from any thread.
+ *
+ * User will be responsible for GC on any heap allocated data that are passed
+ * into the hashmap.
+ *
+ * @author Vincent Mai
+ * @version 0.5.0
+ */
+
+#ifndef CHASHMAP_H
+#define CHASHMAP_H
+
+#include <stdint.h>
+typedef struct ConcurrentHashMap ConcurrentHashMap;
+
+/**
+ * @brief Initializes a concurrent hashmap.
+ *
+ * Hashmap requires manual memory deallocation by calling chashmap_free().
+ *
+ * @param shards The number of shards, rounded up to a power of 2. Use a
+ *               few times the number of threads, 0 picks 64.
+ * @param size The number of entries to make room for.
+ * @param cmp_key The user-defined function for comparing two keys.
+ * @param hash The user-defined hash function for keys.
+ * @param repr_key The user-defined string representation of key.
+ * @param repr_val The user-defined string representation of val.
+ */
+ConcurrentHashMap* chashmap_init(uint32_t shards, uint32_t size,
+                                 int (*cmp_key)(void*, void*),
+                                 uint32_t (*hash)(void*),
+                                 char* (*repr_key)(void*),
+                                 char* (*repr_val)(void*));
+
+/**
+ * @brief Inserts a new key, value pair into the hashmap.
+ *
+ * If key is already present, the value will be overwritten.
+ *
+ * @param cmap The pointer to the hashmap.
+ * @param key The key to be inserted into the hashmap.
+ * @param val The value to be inserted into the hashmap.
+ */
+void chashmap_insert(ConcurrentHashMap* cmap, void* key, void* val);
+
+/**
+ * @brief Inserts a key, value pair unless key is already present.
+ *
+ * Of threads racing to insert the same key, exactly one succeeds and all
+ * of them get its value, which suits memoization.
+ *
+ * @param cmap The pointer to the hashmap.
+ * @param key The key to be inserted into the hashmap.
+ * @param val The value to be inserted into the hashmap.
+ * @return The value of key in the hashmap, val if it was inserted.
+ */
+void* chashmap_get_or_insert(ConcurrentHashMap* cmap, void* key, void* val);
+
+/**
+ * @brief Retrieves a value by a key.
+ *
+ * Returns NULL if key is not found.
+ *
+ * @param cmap The pointer to the hashmap.
+ * @param key The key for retriving the value.
+ */
+void* chashmap_get(ConcurrentHashMap* cmap, void* key);
+
+/**
+ * @brief Removes an entry by the input key.
+ *
+ * Unlike hashmap_remove(), a missing key is not an error, another thread
+ * may have removed it first.
+ *
+ * @param cmap The pointer to the hashmap.
+ * @param key The key for removing the entry.
+ * @return 1 if the entry was removed, 0 if key is not found.
+ */
+int chashmap_remove(ConcurrentHashMap* cmap, void* key);
+
+/**
+ * @brief Counts the entries of the hashmap.
+ *
+ * Shards are counted one at a time, so the count may be stale while
+ * other threads insert or remove.
+ *
+ * @param cmap The pointer to the hashmap.
+ * @return The number of entries.
+ */
+uint32_t chashmap_count(ConcurrentHashMap* cmap);
+
+/**
+ * @brief Empties an entire hashmap, one shard at a time.
+ *
+ * @param cmap The pointer to the hashmap.
+ */
+void chashmap_clear(ConcurrentHashMap* cmap);
+
+/**
+ * @brief Frees the entire hashmap from heap.
+ *
+ * No other thread may use the hashmap meanwhile.
+ *
+ * @param cmap The double pointer to the hashmap.
+ */
+void chashmap_free(ConcurrentHashMap** cmap);
+
+#endif // CHASHMAP_H
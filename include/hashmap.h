@@ -15,6 +15,10 @@
  * User will be responsible for GC on any heap allocated data that are passed 
  * into a linked list.
  *
+ * Entries are stored in a single array probed linearly, with Robin Hood
+ * insertion keeping probe sequences short. The array doubles once it is
+ * 7/8 full, so the hashmap never needs more than a resize per insert.
+ *
  * @author Vincent Mai
  * @version 0.5.0
  */
@@ -22,32 +26,39 @@
 #ifndef HASHMAP_H
 #define HASHMAP_H
 
+#include <stddef.h>
 #include <stdint.h>
 typedef struct HashMap HashMap;
-typedef struct Node Node;
+typedef struct HashEntry HashEntry;
 
 /**
  * @brief Structure for the hashmap.
  */
 struct HashMap {
-    uint32_t size;                 /**< The size of the hashmap */
+    uint32_t size;                 /**< The number of slots, a power of 2 */
+    uint32_t count;                /**< The number of entries */
     int (*cmp_key)(void*, void*);  /**< func to compare keys */ 
     uint32_t (*hash)(void*);       /**< func to hash keys */
     char* (*repr_key)(void*);      /**< func to represent key as string */
     char* (*repr_val)(void*);      /**< func to represent key as string */
-    Node** map;                    /**< an array of chained nodes */
+    void* (*malloc_fn)(size_t);    /**< func to allocate the map and slots */
+    void (*free_fn)(void*);        /**< func to free what malloc_fn gave */
+    HashEntry* entries;            /**< the slots, probed linearly */
 };
 
 /**
  * @brief Initializes a hashmap.
  *
- * Hashmap requires manual memory deallocation by calling hashmap_empty().
+ * Hashmap requires manual memory deallocation by calling hashmap_free().
  *
- * @param size The size of the hashmap.
+ * @param size The number of entries to make room for, the hashmap grows
+ *             past it on its own.
  * @param cmp_key The user-defined function for comparing two keys.
  * @param hash The user-defined hash function for keys.
- * @param repr_key The user-defined string representation of key.
- * @param repr_val The user-defined string representation of val.
+ * @param repr_key The user-defined string representation of key, freed with
+ *                 free(), or NULL if the keys are never printed.
+ * @param repr_val The user-defined string representation of val, freed with
+ *                 free(), or NULL if the values are never printed.
  */
 HashMap* hashmap_init(uint32_t size,
                       int (*cmp_key)(void*, void*),
@@ -55,6 +66,28 @@ HashMap* hashmap_init(uint32_t size,
                       char* (*repr_key)(void*),
                       char* (*repr_val)(void*));
 
+/**
+ * @brief Initializes a hashmap whose memory comes from malloc_fn.
+ *
+ * Like hashmap_init(), except that the hashmap and its slots are allocated
+ * by malloc_fn and released by free_fn, e.g. to account for them.
+ *
+ * @param size The number of entries to make room for.
+ * @param cmp_key The user-defined function for comparing two keys.
+ * @param hash The user-defined hash function for keys.
+ * @param repr_key The user-defined string representation of key, or NULL.
+ * @param repr_val The user-defined string representation of val, or NULL.
+ * @param malloc_fn Replacement for malloc.
+ * @param free_fn Replacement for free.
+ */
+HashMap* hashmap_init_alloc(uint32_t size,
+                            int (*cmp_key)(void*, void*),
+                            uint32_t (*hash)(void*),
+                            char* (*repr_key)(void*),
+                            char* (*repr_val)(void*),
+                            void* (*malloc_fn)(size_t),
+                            void (*free_fn)(void*));
+
 /**
  * @brief Inserts a new key, value pair into the hashmap.
  *
@@ -66,6 +99,25 @@ HashMap* hashmap_init(uint32_t size,
  */
 void hashmap_insert(HashMap* hmap, void* key, void* val);
 
+/**
+ * @brief Inserts a key, value pair whose key hash is already known.
+ *
+ * @param hmap The pointer to the hashmap.
+ * @param key The key to be inserted into the hashmap.
+ * @param val The value to be inserted into the hashmap.
+ * @param hash The hash of key, as returned by the hash function.
+ */
+void hashmap_insert_hashed(HashMap* hmap, void* key, void* val,
+                           uint32_t hash);
+
+/**
+ * @brief Makes room for count entries without resizing.
+ *
+ * @param hmap The pointer to the hashmap.
+ * @param count The number of entries to make room for.
+ */
+void hashmap_reserve(HashMap* hmap, uint32_t count);
+
 /**
  * @brief Retrieves a value by a key.
  *
@@ -76,6 +128,15 @@ void hashmap_insert(HashMap* hmap, void* key, void* val);
  */
 void* hashmap_get(HashMap* hmap, void* key);
 
+/**
+ * @brief Retrieves a value by a key whose hash is already known.
+ *
+ * @param hmap The pointer to the hashmap.
+ * @param key The key for retriving the value.
+ * @param hash The hash of key, as returned by the hash function.
+ */
+void* hashmap_get_hashed(HashMap* hmap, void* key, uint32_t hash);
+
 /**
  * @brief Frees the entire hashmap from heap.
  * 
@@ -93,6 +154,24 @@ void hashmap_free(HashMap** hmap);
  */
 void hashmap_remove(HashMap* hmap, void* key);
 
+/**
+ * @brief Removes an entry by a key whose hash is already known.
+ *
+ * @param hmap The pointer to the hashmap.
+ * @param key The key for removing the entry.
+ * @param hash The hash of key, as returned by the hash function.
+ * @return 1 if the entry was removed, 0 if key is not found.
+ */
+int hashmap_remove_hashed(HashMap* hmap, void* key, uint32_t hash);
+
+/**
+ * @brief Counts the bytes the hashmap holds, its slots included.
+ *
+ * @param hmap The pointer to the hashmap.
+ * @return The bytes allocated for the hashmap.
+ */
+size_t hashmap_bytes(HashMap* hmap);
+
 /**
  * @brief Prints the hashmap entries one per line.
  * 
@@ -102,6 +181,8 @@ void hashmap_print(HashMap* hmap);
 
 /**
  * @brief Empties an entire hashmap
+ *
+ * The slots are kept for the entries to come.
  * 
  * @param hmap The pointer to the hashmap.
  */
@@ -25,6 +25,7 @@
 typedef struct LinkedList LinkedList;
 typedef struct Node Node;
 typedef struct Node Iterator;
+typedef struct NodeStore NodeStore;
 
 /**
  * @brief Structure for a linked list.
@@ -33,6 +34,7 @@ struct LinkedList {
     int (*cmp_data)(void*, void*); /**< User-defined func to  compare data*/
     char* (*repr_data)(void*);     /**< User-defined func to print data */
     Node* head;                    /**< The head of the linked list */
+    NodeStore* store;              /**< Private storage of the nodes */
 };
 
 /**
@@ -75,6 +77,16 @@ void linkedlist_update(LinkedList* list, void* data);
  */
 void linkedlist_print(LinkedList* list);
 
+/**
+ * @brief Empties the linked list.
+ *
+ * Returns the node storage to the heap a slab at a time, keeping one slab
+ * for the pushes that follow.
+ *
+ * @param list A pointer to the linked list.
+ */
+void linkedlist_clear(LinkedList* list);
+
 /**
  * @brief Frees all nodes in the linked list from heap.
  *
@@ -111,8 +123,12 @@ void* linkedlist_iter(LinkedList* list);
 /**
  * @brief Returns the next item from the iterator
  *
- * @param list A double pointer to an iterator of the linked list.
- * @returns An iterator of the linked list.
+ * The iterator advances to the following node. Once it has passed the
+ * last node every call returns NULL, so a loop may run until NULL as
+ * long as the list holds no NULL data.
+ *
+ * @param iter A double pointer to an iterator of the linked list.
+ * @returns The data of the next node, or NULL at the end of the list.
  */
 void* linkedlist_next(Iterator** iter);
 
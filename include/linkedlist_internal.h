@@ -0,0 +1,59 @@
+/**
+ * @file linkedlist_internal.h
+ * @brief Private header for unit testing the generic linked list.
+ *
+ * Subject to change without notice.
+ *
+ * @author Vincent Mai
+ * @version 0.5.0
+ */
+
+#ifndef LINKEDLIST_INTERNAL_H
+#define LINKEDLIST_INTERNAL_H
+
+#include "linkedlist.h"
+
+/* Nodes of a slab */
+#define SLAB_NODES 64
+
+typedef struct Slab Slab;
+
+/**
+ * struct Node - a node of a linked list.
+ *
+ * @data The user data.
+ * @next The next node, NULL for the last one.
+ */
+struct Node {
+    void* data;
+    Node* next;
+};
+
+/**
+ * struct Slab - storage for SLAB_NODES nodes, allocated at once.
+ *
+ * @next The slab allocated before, NULL for the first.
+ * @nodes The nodes, handed out in order.
+ */
+struct Slab {
+    Slab* next;
+    Node nodes[SLAB_NODES];
+};
+
+/**
+ * struct NodeStore - the node storage of a linked list.
+ *
+ * Nodes are carved out of slabs of many nodes, popped nodes are kept for
+ * the next push, so pushes rarely reach malloc.
+ *
+ * @slabs The node storage, newest slab first.
+ * @spare Popped nodes, reused first.
+ * @used Nodes taken from the newest slab.
+ */
+struct NodeStore {
+    Slab* slabs;
+    Node* spare;
+    unsigned used;
+};
+
+#endif // LINKEDLIST_INTERNAL_H
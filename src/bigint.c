@@ -6,36 +6,376 @@
  * @version 0.5.0
  */
 
-#include "hashmap.h"
 #include "bigint/bigint.h"
+#include "hashmap.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
 #include <assert.h>
+#include <time.h>
 
+/*
+ * Limb base. Building with -DBIGINT_BINARY_LIMBS stores 2^32 limbs, so
+ * every reduction by BASE is a shift or a mask and decimal conversion only
+ * happens in bigint_init and bigint_to_str. The default base 10^9 keeps
+ * both conversions linear.
+ */
+#ifdef BIGINT_BINARY_LIMBS
+#define BASE 4294967296L
+#else
 #define BASE 1000000000L
+#endif
+
+/* Decimal chunks parsed by __to_base_giga and printed by bigint_to_str */
+#define GIGA 1000000000L
 #define LEN_BASE 9
 
+/* Chunks up to which the binary base conversions use the quadratic loop */
+#ifndef CONV_THRESHOLD
+#define CONV_THRESHOLD 32
+#endif
+
+/* Operand size (in digits) from which __mult switches to Karatsuba */
+#ifndef KARATSUBA_THRESHOLD
+#define KARATSUBA_THRESHOLD 32
+#endif
+
+/* Operand size (in digits) from which __mult switches to Toom-3 */
+#ifndef TOOM3_THRESHOLD
+#define TOOM3_THRESHOLD 300
+#endif
+
+/* Operand size (in digits) from which __mult switches to Toom-4 */
+#ifndef TOOM4_THRESHOLD
+#define TOOM4_THRESHOLD 700
+#endif
+
+/* Largest product degree of the supported Toom-Cook splits (Toom-4) */
+#define TOOM_MAX_DEG 6
+
+/* Operand size (in digits) from which __mult switches to the NTT */
+#ifndef NTT_THRESHOLD
+#define NTT_THRESHOLD 5000
+#endif
+
+/*
+ * Longest NTT convolution, bounded by the 2^23 roots of unity of the
+ * first prime. Operands up to half of it keep every convolution sum
+ * below the product of the three primes, so the CRT is exact.
+ */
+#define NTT_MAX_LEN (1 << 23)
+#define NTT_PRIMES 3
+
+/* Binary limbs exceed the primes, they are convolved as 16 bit halves */
+#ifdef BIGINT_BINARY_LIMBS
+#define NTT_SPLIT 2
+#else
+#define NTT_SPLIT 1
+#endif
+
+/* Modulus size (in digits) up to which __modctx_mul uses Montgomery */
+#ifndef MONT_MAX_LEN
+#define MONT_MAX_LEN 64
+#endif
+
+/* Scratch limbs of __modctx_mul for a modulus of len limbs */
+#define MODCTX_SCRATCH(len) (7 * (len) + 6)
+
+/* Exponent bits per digit of __to_base_bits */
+#define EXP_BITS 30
+
+/* Divisor and quotient size (in digits) from which __divmod recurses */
+#ifndef DIV_DC_THRESHOLD
+#define DIV_DC_THRESHOLD 24
+#endif
+
+/* The secret primes of wyhash, mixed into __hash_limbs */
+#define HASH_P0 0xa0761d6478bd642full
+#define HASH_P1 0xe7037ed1a0b428dbull
+#define HASH_P2 0x8ebc6af09c88c6e3ull
+#define HASH_P3 0x589965cc75374cc3ull
+
+/* Limbs stored inside struct BigInt before the digits move to the heap */
+#define INLINE_LIMBS 2
+
+/* Smallest block (in limbs) the scratch arena requests from the allocator */
+#ifndef SCRATCH_BLOCK
+#define SCRATCH_BLOCK 4096
+#endif
+
+/*
+ * Digit arrays of 2^POOL_MIN_CLASS up to 2^POOL_MAX_CLASS words come in
+ * power of two size classes and are cached per thread, POOL_CACHE of
+ * each class at most.
+ */
+#define POOL_MIN_CLASS 2
+#define POOL_MAX_CLASS 12
+#define POOL_CLASSES (POOL_MAX_CLASS - POOL_MIN_CLASS + 1)
+#ifndef POOL_CACHE
+#define POOL_CACHE 64
+#endif
+
+#ifdef BIGINT_STATS
+/* Bytes in front of every allocation, holding its size */
+#define STATS_HEADER 16
+
+/*
+ * Counts a call of a public function with the limbs of its operands and
+ * times it until the function returns. Calls the library makes to its
+ * own public functions are part of the outermost call. STATS_COUNT only
+ * counts, for functions too cheap to be worth a clock read.
+ */
+#define STATS(op, limbs)                                                    \
+    __attribute__((cleanup(__stats_end))) struct StatsCall stats_call =     \
+        __stats_begin((op), (limbs), 1)
+#define STATS_COUNT(op, limbs)                                              \
+    __attribute__((cleanup(__stats_end))) struct StatsCall stats_call =     \
+        __stats_begin((op), (limbs), 0)
+#else
+#define STATS(op, limbs)
+#define STATS_COUNT(op, limbs)
+#endif
+
+typedef unsigned __int128 uint128_t;
+
+/*
+ * Allocator of the library, replaced by bigint_set_allocator. The hooks
+ * are read through HOOK, e.g. HOOK(malloc)(size).
+ */
+static void* (*hook_malloc)(size_t) = malloc;
+static void* (*hook_realloc)(void*, size_t) = realloc;
+static void (*hook_free)(void*) = free;
+#define HOOK(fn) __atomic_load_n(&hook_##fn, __ATOMIC_ACQUIRE)
+
+/*
+ * The free function of the blocks held by the arena and pool of this
+ * thread, NULL while they hold none. Blocks cached before the allocator
+ * was replaced go back through the free function they came from.
+ */
+static _Thread_local void (*held_free)(void*);
+
+/**
+ * struct StatsCall - a public call being timed by a BIGINT_STATS build.
+ *
+ * @op The operation, -1 for a call nested in another one or not timed.
+ * @start The monotonic clock at the call, in nanoseconds.
+ */
+struct StatsCall
+{
+    int op;
+    uint64_t start;
+};
+
+/* Counters of a BIGINT_STATS build, shared by all threads */
+static BigIntStats stats;
+static _Thread_local uint32_t stats_depth;
+
+static const char* stats_names[BIGINT_OPS] = {
+    [BIGINT_OP_INIT] = "init",
+    [BIGINT_OP_INT_INIT] = "int_init",
+    [BIGINT_OP_FIXED_INIT] = "fixed_init",
+    [BIGINT_OP_TO_STR] = "to_str",
+    [BIGINT_OP_NUM_DIGITS] = "num_digits",
+    [BIGINT_OP_ADD] = "add",
+    [BIGINT_OP_SUBTR] = "subtr",
+    [BIGINT_OP_MULT] = "mult",
+    [BIGINT_OP_SQR] = "sqr",
+    [BIGINT_OP_DIV] = "div",
+    [BIGINT_OP_MOD] = "mod",
+    [BIGINT_OP_LOG] = "log",
+    [BIGINT_OP_POWER_MOD] = "power_mod",
+    [BIGINT_OP_ADD_TO] = "add_to",
+    [BIGINT_OP_SUBTR_TO] = "subtr_to",
+    [BIGINT_OP_MULT_TO] = "mult_to",
+    [BIGINT_OP_DIV_TO] = "div_to",
+    [BIGINT_OP_MOD_TO] = "mod_to",
+    [BIGINT_OP_POWER_MOD_TO] = "power_mod_to",
+    [BIGINT_OP_MODCTX_INIT] = "modctx_init",
+    [BIGINT_OP_MOD_CTX] = "mod_ctx",
+    [BIGINT_OP_MULMOD_CTX] = "mulmod_ctx",
+    [BIGINT_OP_POWMOD_CTX] = "powmod_ctx",
+    [BIGINT_OP_MODCTX_FREE] = "modctx_free",
+    [BIGINT_OP_CACHE_INIT] = "cache_init",
+    [BIGINT_OP_CACHE_DIV] = "cache_div",
+    [BIGINT_OP_CACHE_MOD] = "cache_mod",
+    [BIGINT_OP_CACHE_POWER_MOD] = "cache_power_mod",
+    [BIGINT_OP_CACHE_TO_STR] = "cache_to_str",
+    [BIGINT_OP_CACHE_STATS] = "cache_stats",
+    [BIGINT_OP_CACHE_CLEAR] = "cache_clear",
+    [BIGINT_OP_CACHE_FREE] = "cache_free",
+    [BIGINT_OP_ABS] = "abs",
+    [BIGINT_OP_NEG] = "neg",
+    [BIGINT_OP_ST] = "st",
+    [BIGINT_OP_GT] = "gt",
+    [BIGINT_OP_EQ] = "eq",
+    [BIGINT_OP_COPY] = "copy",
+    [BIGINT_OP_REF] = "ref",
+    [BIGINT_OP_UNREF] = "unref",
+    [BIGINT_OP_RESERVE] = "reserve",
+    [BIGINT_OP_SHRINK_TO_FIT] = "shrink_to_fit",
+    [BIGINT_OP_SET_ALLOCATOR] = "set_allocator",
+    [BIGINT_OP_SCRATCH_RELEASE] = "scratch_release",
+    [BIGINT_OP_POOL_OCCUPANCY] = "pool_occupancy",
+    [BIGINT_OP_POOL_TRIM] = "pool_trim",
+    [BIGINT_OP_HASH] = "hash",
+    [BIGINT_OP_HASH64] = "hash64",
+    [BIGINT_OP_HASH_BULK] = "hash_bulk",
+    [BIGINT_OP_FREE] = "free",
+};
+
+/**
+ * struct ScratchBlock - a block of the scratch arena.
+ *
+ * Blocks are chained in allocation order and never move, a full block
+ * continues in the next one.
+ *
+ * @prev The block before, NULL for the first.
+ * @next The block after, kept for reuse once released.
+ * @cap The number of limbs of the block.
+ * @limbs The block itself.
+ */
+struct ScratchBlock
+{
+    struct ScratchBlock* prev;
+    struct ScratchBlock* next;
+    size_t cap;
+    uint32_t limbs[];
+};
+
+/**
+ * struct Scratch - a thread-local bump arena for temporary limb spans.
+ *
+ * Spans are released in the reverse order of their allocation, so the
+ * arena is empty again when a top-level operation returns. Blocks are
+ * kept across operations, a chain of several is merged into a single
+ * block once the arena is empty.
+ *
+ * @head The first block, NULL before the first allocation.
+ * @block The block spans are bumped from, NULL while the arena is empty.
+ * @top The number of limbs in use in block.
+ * @hint The size of the merged block to allocate next.
+ */
+struct Scratch
+{
+    struct ScratchBlock* head;
+    struct ScratchBlock* block;
+    size_t top;
+    size_t hint;
+};
+
+static _Thread_local struct Scratch scratch;
+
+/**
+ * struct Pool - a thread-local cache of free digit arrays.
+ *
+ * Free arrays are linked through their first words, class k holds
+ * arrays of at least 2^(k + POOL_MIN_CLASS) words.
+ *
+ * @head The first free array of each class.
+ * @count The number of free arrays of each class.
+ */
+struct Pool
+{
+    uint32_t* head[POOL_CLASSES];
+    uint32_t count[POOL_CLASSES];
+};
+
+static _Thread_local struct Pool pool;
+
 /**
  * struct BigInt - stores big integer
  * 
- * Big integers are represented with Base-giga digits.
+ * Big integers are represented with Base-giga digits, or base 2^32 digits
+ * when built with BIGINT_BINARY_LIMBS, and a separate sign.
  * Inspired by CPython Bignum (PEP 237), which stores
  * big numbers in Base-30-bit.
  *
- * @sign_len Stores the sign and number of decimal digits.
- * @digits Stores the digits in Base-giga in little-endian order.
+ * The struct is a handle: the digits live inline in small until the value
+ * outgrows it, then in a heap buffer that copies may share, or in caller
+ * storage for a fixed BigInt, see bigint_fixed_init.
+ *
+ * @sign Stores the sign, 1 or -1, zero is positive.
+ * @len_dec Caches the number of decimal digits, 0 until computed by
+ *          bigint_num_digits or bigint_to_str.
+ * @digits Stores the digits in Base-giga (base 2^32 when built with
+ *         BIGINT_BINARY_LIMBS) in little-endian order, the limb count
+ *         at index 0.
+ * @cap Stores the number of limbs the digit buffer has room for, not
+ *      counting the limb count at index 0.
+ * @refs Counts the references to the handle, see bigint_ref.
+ * @shared Counts the BigInts sharing the digit buffer, NULL while it has
+ *         a single owner. Writers clone a shared buffer first. Points to
+ *         a marker instead when the digits are borrowed caller storage.
+ * @small Inline digit buffer, digits points here until the value
+ *        outgrows INLINE_LIMBS limbs, so small values need no allocation.
  */
 
 struct BigInt
 {
-    int32_t sign_len;
+    int32_t sign;
+    uint32_t len_dec;
     uint32_t* digits;
+    uint32_t cap;
+    uint32_t refs;
+    uint32_t* shared;
+    uint32_t small[INLINE_LIMBS + 1];
 };
 
+_Static_assert(sizeof(struct BigInt) <= BIGINT_HANDLE_SIZE,
+               "BIGINT_HANDLE_SIZE is smaller than struct BigInt");
+
+/*
+ * The shared counter of digit buffers a BigInt does not own, the storage
+ * of bigint_fixed_init and scratch temporaries. They are never freed,
+ * shared or grown.
+ */
+static uint32_t borrowed;
+
 /** internal uses */
-BigInt* _neg(BigInt* n); // TODO: do this without using BigInt.
+BigInt* _wrap(uint32_t* digits, int32_t sign);
+BigInt* _alloc();
+BigInt* _new();
+void _unshare(BigInt* n);
+void _move(BigInt* dst, BigInt* src);
+void _assign(BigInt* dst, BigInt* src);
+void _borrow(BigInt* n, uint32_t* digits, uint32_t cap);
+void _set_result(BigInt* n, int32_t sign);
+void* mem_malloc(size_t size);
+void* mem_realloc(void* p, size_t size);
+void mem_free(void* p);
+void __mem_free_with(void* p, void (*free_fn)(void*));
+void __held_sync();
+void __held_release(void (*free_fn)(void*));
+struct StatsCall __stats_begin(int op, uint64_t limbs, int timed);
+void __stats_end(struct StatsCall* call);
+void __stats_alloc(int64_t bytes);
+uint64_t __stats_now();
+void _init_inline(BigInt* n);
+void _adopt(BigInt* n, uint32_t* digits);
+void _free_digits(BigInt* n);
+int _is_inline(BigInt* n);
+int _is_borrowed(BigInt* n);
+int __both_small(const BigInt* a, const BigInt* b);
+uint64_t __small_value(uint32_t* digits);
+void __set_small(BigInt* n, uint128_t v, int32_t sign);
+void __divmod_small(BigInt* q, BigInt* r, const BigInt* n, const BigInt* d);
+uint64_t __hash_value(const BigInt* n);
+uint64_t __hash_mum(uint64_t a, uint64_t b);
+uint64_t __hash_limbs(uint32_t* limbs, uint32_t len, uint64_t seed);
+uint32_t* __scratch(size_t len);
+uint32_t* __scratch_zero(size_t len);
+void __scratch_free(uint32_t* span);
+void __scratch_release();
+size_t __pool_size(size_t words);
+uint32_t* __pool_get(size_t words);
+void __pool_put(uint32_t* digits, size_t words);
+void __free_digits(uint32_t* digits);
+void __reserve_digits(BigInt* n, uint32_t len);
+void __resize_digits(BigInt* n, uint32_t cap);
+void __add_signed_to(BigInt* dst, const BigInt* a, const BigInt* b,
+                     int32_t sign_b);
+void __divmod_to(BigInt* q, BigInt* r, const BigInt* n, const BigInt* d);
 
 /**
  * struct QuoRem - stores a quotian and a remainder.
@@ -53,10 +393,159 @@ struct QuoRem
     uint32_t* remainder;
 };
 
+/**
+ * struct BigIntModCtx - precomputed state for arithmetic modulo m.
+ *
+ * Residues are spans of exactly len limbs. For a modulus coprime to
+ * BASE they are kept in Montgomery form a * R mod m with R = BASE^len,
+ * otherwise they are plain and every product is reduced by Barrett.
+ * The context is never written after initialization.
+ *
+ * @m The modulus as a limb span.
+ * @len The number of limbs of m.
+ * @sign The sign of the modulus, 1 or -1.
+ * @m_inv -m^-1 modulo BASE, 0 when m is not coprime to BASE.
+ * @one The residue of 1.
+ * @mu The Barrett constant floor(BASE^(2 len) / m).
+ * @len_mu The number of limbs of mu, 0 when mu is not computed.
+ */
+struct BigIntModCtx
+{
+    uint32_t* m;
+    uint32_t len;
+    int32_t sign;
+    uint32_t m_inv;
+    uint32_t* one;
+    uint32_t* mu;
+    uint32_t len_mu;
+};
+
+/* Most operands of a cached operation */
+#define CACHE_ARGS 3
+
+_Static_assert(BIGINT_OPS <= 64, "BIGINT_CACHE_OP needs an op per bit");
+
+/**
+ * struct CacheEntry - a result remembered by a BigIntCache.
+ *
+ * The entry is its own key in the hashmap of the cache, and a node of
+ * its recency list.
+ *
+ * @op The operation, an enum BigIntOp.
+ * @n_args The number of operands.
+ * @hash The hash of op and the operand values.
+ * @args Copies of the operands.
+ * @res The result, NULL for bigint_cache_to_str.
+ * @str The string of bigint_cache_to_str, NULL otherwise.
+ * @bytes The bytes held by the entry.
+ * @prev The more recently used entry, NULL for the most recent.
+ * @next The less recently used entry, NULL for the least recent.
+ */
+struct CacheEntry
+{
+    int op;
+    uint32_t n_args;
+    uint32_t hash;
+    BigInt* args[CACHE_ARGS];
+    BigInt* res;
+    char* str;
+    size_t bytes;
+    struct CacheEntry* prev;
+    struct CacheEntry* next;
+};
+
+/**
+ * struct BigIntCache - a bounded cache of results, see bigint_cache_init.
+ *
+ * @map The entries by their operation and operands.
+ * @head The most recently used entry.
+ * @tail The least recently used entry, evicted first.
+ * @budget The most bytes the entries and map may hold.
+ * @ops The cached operations, a bit per enum BigIntOp.
+ * @stats The counters.
+ */
+struct BigIntCache
+{
+    HashMap* map;
+    struct CacheEntry* head;
+    struct CacheEntry* tail;
+    size_t budget;
+    uint64_t ops;
+    BigIntCacheStats stats;
+};
+
 /* Constant unsigned digits */
 static uint32_t U_DIGIT_ZERO[2] = {1, 0};
 static uint32_t U_DIGIT_ONE[2]  = {1, 1};
-static uint32_t U_DIGIT_TWO[2]  = {1, 2};
+
+/* Multiplication tuning, may be lowered by the test suite */
+uint32_t __karatsuba_threshold = KARATSUBA_THRESHOLD;
+uint32_t __toom3_threshold = TOOM3_THRESHOLD;
+uint32_t __toom4_threshold = TOOM4_THRESHOLD;
+uint32_t __div_dc_threshold = DIV_DC_THRESHOLD;
+
+/*
+ * Toom-Cook evaluation points, a product of degree d is evaluated at the
+ * first d points plus infinity.
+ */
+static const int32_t TOOM_POINTS[TOOM_MAX_DEG] = {0, 1, -1, 2, -2, 3};
+
+/*
+ * Toom-Cook interpolation, inverse of the Vandermonde matrix over
+ * TOOM_POINTS scaled by TOOM_DEN[d]. Row i yields coefficient i from the
+ * values at the d points followed by the value at infinity. The top
+ * coefficient is the value at infinity itself.
+ */
+static const int32_t TOOM_INTERP_3[] = {
+      2,   0,   0,   0,
+      0,   1,  -1,  -2,
+     -2,   1,   1,   0,
+};
+static const int32_t TOOM_INTERP_4[] = {
+      6,   0,   0,   0,   0,
+     -3,   6,  -2,  -1,  12,
+     -6,   3,   3,   0,  -6,
+      3,  -3,  -1,   1, -12,
+};
+static const int32_t TOOM_INTERP_5[] = {
+     24,   0,   0,   0,   0,   0,
+      0,  16, -16,  -2,   2,  96,
+    -30,  16,  16,  -1,  -1,   0,
+      0,  -4,   4,   2,  -2,-120,
+      6,  -4,  -4,   1,   1,   0,
+};
+static const int32_t TOOM_INTERP_6[] = {
+    120,   0,   0,   0,   0,   0,     0,
+    -40, 120, -60, -30,   6,   4, -1440,
+   -150,  80,  80,  -5,  -5,   0,   480,
+     50, -70,  -5,  35,  -5,  -5,  1800,
+     30, -20, -20,   5,   5,   0,  -600,
+    -10,  10,   5,  -5,  -1,   1,  -360,
+};
+static const int32_t* TOOM_INTERP[TOOM_MAX_DEG + 1] = {
+    NULL, NULL, NULL, TOOM_INTERP_3, TOOM_INTERP_4,
+    TOOM_INTERP_5, TOOM_INTERP_6,
+};
+static const uint32_t TOOM_DEN[TOOM_MAX_DEG + 1] = {0, 0, 0, 2, 6, 24, 120};
+
+uint32_t __ntt_threshold = NTT_THRESHOLD;
+
+/* NTT friendly primes c * 2^k + 1, all with primitive root 3 */
+static const uint32_t NTT_MOD[NTT_PRIMES] = {998244353, 167772161, 469762049};
+
+/**
+ * struct NttPrime - Montgomery constants of one NTT prime.
+ *
+ * @p The prime modulus.
+ * @p_inv -p^-1 modulo 2^32.
+ * @r2 2^64 modulo p, converts into Montgomery form.
+ */
+struct NttPrime
+{
+    uint32_t p;
+    uint32_t p_inv;
+    uint32_t r2;
+};
 
 /* private functions */
 int __same_sign(BigInt* a, BigInt* b);
@@ -65,25 +554,103 @@ int __is_one(uint32_t* n);
 int __gt(uint32_t* a, uint32_t* b);
 int __st(uint32_t* a, uint32_t* b);
 int __eq(uint32_t* a, uint32_t* b);
-void __incr(uint32_t* n);
+uint32_t* __incr(uint32_t* n);
 void __decr(uint32_t* n);
 uint32_t __to_decimal(uint32_t* n);
 uint32_t __len_decimal(uint32_t* digits);
-uint32_t __hash_digits(void* key);
 uint32_t* __to_base_giga(char* sn, int32_t len);
+#ifdef BIGINT_BINARY_LIMBS
+uint32_t* __giga_to_limbs(uint32_t* giga);
+uint32_t* __limbs_to_giga(uint32_t* n);
+uint32_t** __giga_powers(uint32_t len);
+void __giga_powers_free(uint32_t** pw);
+uint32_t __giga_to_limbs_dc(uint32_t* res, uint32_t* g, uint32_t len,
+                            uint32_t** pw);
+void __limbs_to_giga_dc(uint32_t* g, uint32_t len_g, uint32_t* n,
+                        uint32_t len, uint32_t** pw);
+#endif
 uint32_t* __arg_len_max(uint32_t* a, uint32_t* b);
 uint32_t* __arg_len_min(uint32_t* a, uint32_t* b);
 uint32_t* __assign_digits(uint32_t n);
 uint32_t* __copy_digits(uint32_t* n);
 uint32_t* __right_shift(uint32_t* n);
 uint32_t* __mult(uint32_t* a, uint32_t* b);
+uint32_t __add_limbs(uint32_t* res, uint32_t* a, uint32_t len_a,
+                     uint32_t* b, uint32_t len_b);
+uint32_t __subtr_limbs(uint32_t* res, uint32_t* a, uint32_t len_a,
+                       uint32_t* b, uint32_t len_b);
+void __mult_limbs(uint32_t* res, uint32_t* a, uint32_t len_a,
+                  uint32_t* b, uint32_t len_b);
+void __mult_school(uint32_t* res, uint32_t* a, uint32_t len_a,
+                   uint32_t* b, uint32_t len_b);
+void __sqr_school(uint32_t* res, uint32_t* a, uint32_t len);
+void __mult_karatsuba(uint32_t* res, uint32_t* a, uint32_t len_a,
+                      uint32_t* b, uint32_t len_b);
+void __mult_chunked(uint32_t* res, uint32_t* a, uint32_t len_a,
+                    uint32_t* b, uint32_t len_b);
+void __mult_toom(uint32_t* res, uint32_t* a, uint32_t len_a,
+                 uint32_t* b, uint32_t len_b, uint32_t k_a, uint32_t k_b);
+void __toom_eval(uint32_t* res, int* signs, uint32_t* a, uint32_t len_a,
+                 uint32_t len_part, uint32_t k, uint32_t n_points);
+void __mult_ntt(uint32_t* res, uint32_t* a, uint32_t len_a,
+                uint32_t* b, uint32_t len_b);
+void __ntt_init_prime(struct NttPrime* np, uint32_t p);
+uint32_t __ntt_mul(struct NttPrime* np, uint32_t a, uint32_t b);
+uint32_t __ntt_pow(struct NttPrime* np, uint32_t a, uint64_t e);
+void __ntt(struct NttPrime* np, uint32_t* f, uint32_t len, int inverse);
+void __ntt_convolve(struct NttPrime* np, uint32_t* res, uint32_t* a,
+                    uint32_t len_a, uint32_t* b, uint32_t len_b,
+                    uint32_t len);
+uint32_t __addmul_limbs(uint32_t* res, uint32_t len_res,
+                        uint32_t* a, uint32_t len_a, uint32_t m);
+uint32_t __submul_limbs(uint32_t* res, uint32_t* a, uint32_t len_a,
+                        uint32_t m);
+uint32_t __divmod_limb(uint32_t* q, uint32_t* n, uint32_t len, uint32_t d);
+void __divmod_limbs(uint32_t* q, uint32_t* r, uint32_t* n, uint32_t len_n,
+                    uint32_t* d, uint32_t len_d);
+void __divmod_school(uint32_t* q, uint32_t* u, uint32_t len_q,
+                     uint32_t* d, uint32_t len_d);
+void __divmod_dc(uint32_t* q, uint32_t* u, uint32_t len_q,
+                 uint32_t* d, uint32_t len_d);
+void __divexact_limbs(uint32_t* n, uint32_t len, uint32_t d);
+int __cmp_limbs(uint32_t* a, uint32_t* b, uint32_t len);
+uint32_t __trim_limbs(uint32_t* n, uint32_t len);
 uint32_t* __add(uint32_t* a, uint32_t* b);
 uint32_t* __subtr(uint32_t* a, uint32_t* b);
 uint32_t* __slice_digits(uint32_t* n, int start, int end);
-uint32_t* __power_mod(uint32_t* base, uint32_t* exp,
-                     uint32_t* m, HashMap* cache);
+uint32_t* __power_mod(uint32_t* base, uint32_t* exp, uint32_t* m);
+struct BigIntModCtx* __modctx_init(uint32_t* m, int barrett);
+void __modctx_free(struct BigIntModCtx** ctx);
+void __modctx_to(struct BigIntModCtx* ctx, uint32_t* res, uint32_t* n);
+void __modctx_reduce(struct BigIntModCtx* ctx, uint32_t* res, uint32_t* n,
+                     uint32_t len_n);
+BigInt* __modctx_signed(struct BigIntModCtx* ctx, uint32_t* rem,
+                        int positive);
+void __barrett(struct BigIntModCtx* ctx, uint32_t* res, uint32_t* x,
+               uint32_t* tmp);
+uint32_t* __modctx_from(struct BigIntModCtx* ctx, uint32_t* a);
+void __modctx_mul(struct BigIntModCtx* ctx, uint32_t* res, uint32_t* a,
+                  uint32_t* b, uint32_t* tmp);
+uint32_t* __modctx_pow(struct BigIntModCtx* ctx, uint32_t* base, uint32_t* exp);
+uint32_t __mont_inv(uint32_t m0);
+void __mont_mul(uint32_t* res, uint32_t* a, uint32_t* b, uint32_t* m,
+                uint32_t len, uint32_t m_inv, uint32_t* t);
+void __mont_redc(uint32_t* res, uint32_t* t, uint32_t* m, uint32_t len,
+                 uint32_t m_inv, uint32_t* u);
+uint32_t* __to_base_bits(uint32_t* n, uint32_t* n_bits);
 uint32_t** __divmod(uint32_t* n, uint32_t* m);
 struct QuoRem* __single_divmod(uint32_t* n, uint32_t* d);
+void __cache_probe(struct CacheEntry* probe, int op, BigInt** args,
+                   uint32_t n_args);
+struct CacheEntry* __cache_find(BigIntCache* cache, struct CacheEntry* probe);
+void __cache_put(BigIntCache* cache, struct CacheEntry* probe, BigInt* res,
+                 char* str);
+void __cache_unlink(BigIntCache* cache, struct CacheEntry* entry);
+void __cache_drop(BigIntCache* cache, struct CacheEntry* entry);
+size_t __cache_bytes(BigInt* n);
+char* __cache_str(char* s);
+int __cache_eq(void* a, void* b);
+uint32_t __cache_hash(void* entry);
 
 /** debugging functions */
 void print_digits(char* var_name, uint32_t* slice);
@@ -93,344 +660,704 @@ int legal_digits(uint32_t* digits);
 
 BigInt* bigint_init(char* sn) 
 {
-    BigInt* bigint = malloc(sizeof(*bigint));
-    bigint->sign_len = (sn[0] == '-') ?
-        1 - strlen(sn) : strlen(sn);
-    bigint->digits = __to_base_giga(sn, abs(bigint->sign_len));
-
-    if (*(bigint->digits) == 1 && bigint->digits[1] == 0) {
-        bigint->sign_len = 1;
-    }
+    STATS(BIGINT_OP_INIT, strlen(sn) / LEN_BASE + 1);
+    BigInt* bigint = _new();
+    int negative = (sn[0] == '-');
+    int32_t len = strlen(sn) - negative;
+    uint32_t* digits = __to_base_giga(sn, len);
+    *digits = __trim_limbs(digits + 1, *digits);
+
+#ifdef BIGINT_BINARY_LIMBS
+    uint32_t* giga = digits;
+    digits = __giga_to_limbs(giga);
+    __free_digits(giga);
+#endif
+
+    _adopt(bigint, digits);
+    bigint->sign = (negative && ! __is_zero(bigint->digits)) ? -1 : 1;
+    /* without leading zeros the string gives the decimal length for free */
+    bigint->len_dec = (sn[negative] != '0' || len == 1) ? len : 0;
     return bigint;
 }
 
 BigInt* bigint_int_init(int32_t n) 
 {
-    // TODO: delegate to __assign_digits(n);
-    BigInt* bigint = malloc(sizeof(*bigint));
-
-    // BUG: counting decimal digits wrong
-    bigint->sign_len = 0;
-    int dec_digits = n;
-    while (dec_digits != 0) {
-        dec_digits /= 10;
-        if (n > 0) ++(bigint->sign_len);
-        else --(bigint->sign_len);
-    }
-
-    if (n == 0) bigint->sign_len = 1;
-
-    uint32_t* digits = malloc(2 * sizeof(*digits));
-    if (n < BASE) {
-        *digits = 1;
-        digits[1] = abs(n);
-    } else {
-        *digits = 2;
-        digits[1] = abs(n % BASE);
-        digits[2] = abs(n / BASE);
-    }
-    bigint->digits = digits;
+    STATS_COUNT(BIGINT_OP_INT_INIT, 1);
+    uint32_t mag = (n < 0) ? -(uint32_t) n : n;
+    BigInt* bigint = _new();
+    _init_inline(bigint);
+    bigint->small[1] = mag % BASE;
+    bigint->small[2] = mag / BASE;
+    bigint->small[0] = bigint->small[2] ? 2 : 1;
+    bigint->sign = (n < 0) ? -1 : 1;
+    bigint->len_dec = 0;
     return bigint;
 }
 
-char* bigint_to_str(BigInt* n) 
+BigInt* bigint_fixed_init(uint64_t* storage, uint32_t limbs) 
 {
-    int32_t len = (n->sign_len < 0) ?
-        abs(n->sign_len)+1 : n->sign_len;
+    STATS_COUNT(BIGINT_OP_FIXED_INIT, 0);
+    /* even zero takes a limb */
+    if (limbs < 1) return NULL;
+    BigInt* n = (BigInt*) storage;
+    n->refs = 1;
+    _borrow(n, (uint32_t*) ((char*) storage + BIGINT_HANDLE_SIZE), limbs);
+    return n;
+}
 
-    char* s = malloc((len + 1) * sizeof(*s));
+char* bigint_to_str(BigInt* n) 
+{
+    STATS(BIGINT_OP_TO_STR, *(n->digits));
+#ifdef BIGINT_BINARY_LIMBS
+    uint32_t* digits = __limbs_to_giga(n->digits);
+#else
+    uint32_t* digits = n->digits;
+#endif
+    int32_t len = LEN_BASE * *digits + (n->sign < 0);
+
+    /* the caller frees the string, it bypasses the statistics */
+    char* s = HOOK(malloc)((len + 1) * sizeof(*s));
     char* s_i = s;
-    if (n->sign_len < 0) {
+    if (n->sign < 0) {
         *s = '-';
         ++s_i;
     } 
 
-    int i_th = *(n->digits);
+    int i_th = *(digits);
     //sprintf returns len of formatted string
-    s_i += sprintf(s_i, "%u", n->digits[i_th]); 
+    s_i += sprintf(s_i, "%u", digits[i_th]); 
     --i_th;
 
     while (i_th > 0) {
-        s_i += sprintf(s_i, "%0*u", LEN_BASE, n->digits[i_th]);
+        s_i += sprintf(s_i, "%0*u", LEN_BASE, digits[i_th]);
         --i_th;
     }
+    /*
+     * Shared constants come with their length, they are never written.
+     * Concurrent readers may fill in the cache together, with one value.
+     */
+    if (! __atomic_load_n(&n->len_dec, __ATOMIC_RELAXED))
+        __atomic_store_n(&n->len_dec, s_i - s - (n->sign < 0), __ATOMIC_RELAXED);
+
+#ifdef BIGINT_BINARY_LIMBS
+    __free_digits(digits);
+#endif
     return s;
 }
 
-BigInt* bigint_mult(BigInt* a, BigInt* b) 
+uint32_t bigint_num_digits(BigInt* n) 
 {
-    if (__is_zero(a->digits) || __is_zero(b->digits))
-        return bigint_int_init(0);
+    STATS(BIGINT_OP_NUM_DIGITS, *(n->digits));
+    uint32_t len_dec = __atomic_load_n(&n->len_dec, __ATOMIC_RELAXED);
+    if (len_dec == 0) {
+#ifdef BIGINT_BINARY_LIMBS
+        uint32_t* giga = __limbs_to_giga(n->digits);
+        len_dec = __len_decimal(giga);
+        __free_digits(giga);
+#else
+        len_dec = __len_decimal(n->digits);
+#endif
+        __atomic_store_n(&n->len_dec, len_dec, __ATOMIC_RELAXED);
+    }
+    return len_dec;
+}
 
-    BigInt* res = malloc(sizeof(*res));
-    uint32_t* digits = __mult(a->digits, b->digits);
-    res->sign_len = __len_decimal(digits);
-    res->digits = digits;
+BigInt* bigint_mult(BigInt* a, BigInt* b) 
+{
+    STATS(BIGINT_OP_MULT, *(a->digits) + *(b->digits));
+    BigInt* res = _alloc();
+    bigint_mult_to(res, a, b);
+    return res;
+}
 
-    return (__same_sign(a, b)) ? res : _neg(res);
+BigInt* bigint_sqr(BigInt* n) 
+{
+    STATS(BIGINT_OP_SQR, *(n->digits));
+    BigInt* res = _alloc();
+    bigint_mult_to(res, n, n);
+    return res;
 }
 
 BigInt* bigint_add(BigInt* a, BigInt* b) 
 {
-    BigInt* res = malloc(sizeof(*res));
-    if (! __same_sign(a, b)) {
-        if (a->sign_len > 0) {
-            res = bigint_subtr(a, _neg(b));
-            b = _neg(b);
-        } else {
-            res = bigint_subtr(b, _neg(a));
-            a = _neg(a);
-        }
-        return res;
-    }
-    res->digits = __add(a->digits, b->digits);
-    res->sign_len = __len_decimal(res->digits);
-    return (a->sign_len < 0) ? _neg(res) : res; 
+    STATS(BIGINT_OP_ADD, *(a->digits) + *(b->digits));
+    BigInt* res = _alloc();
+    bigint_add_to(res, a, b);
+    return res;
 }
 
 BigInt* bigint_subtr(BigInt* a, BigInt* b) 
 {
-    BigInt* res = malloc(sizeof(*res));
-    if (! __same_sign(a, b)) {
-        res->digits = __add(a->digits, b->digits);
-        res->sign_len = __len_decimal(res->digits);
-        if (a->sign_len <= 0) res->sign_len *= -1;
-        return res;
-    }
-    int sign = 1;
-    if (bigint_eq(a, b)) {
-        res->digits = __copy_digits(U_DIGIT_ZERO);
-    } else if (bigint_gt(a, b)) {
-        res->digits = (a->sign_len >= 0) ? 
-            __subtr(a->digits, b->digits) :
-            __subtr(b->digits, a->digits);
-    } else {
-        sign *= -1;
-        res->digits = (a->sign_len >= 0) ? 
-            __subtr(b->digits, a->digits) :
-            __subtr(a->digits, b->digits);
-    }
-    res->sign_len = __len_decimal(res->digits) * sign;
+    STATS(BIGINT_OP_SUBTR, *(a->digits) + *(b->digits));
+    BigInt* res = _alloc();
+    bigint_subtr_to(res, a, b);
     return res;
 }
 
 BigInt* bigint_div(BigInt* n, BigInt* d) 
 {
+    STATS(BIGINT_OP_DIV, *(n->digits) + *(d->digits));
+    BigInt* res = _alloc();
+    bigint_div_to(res, n, d);
+    return res;
+}
+
+/* true modulo as opposed to the default C remainder operation */
+BigInt* bigint_mod(BigInt* n, BigInt* m) 
+{
+    STATS(BIGINT_OP_MOD, *(n->digits) + *(m->digits));
+    BigInt* res = _alloc();
+    bigint_mod_to(res, n, m);
+    return res;
+}
+
+/**************************** DESTINATION OPERANDS ****************************/
+
+void bigint_add_to(BigInt* dst, const BigInt* a, const BigInt* b) 
+{
+    STATS(BIGINT_OP_ADD_TO, *(a->digits) + *(b->digits));
+    __add_signed_to(dst, a, b, b->sign);
+}
+
+void bigint_subtr_to(BigInt* dst, const BigInt* a, const BigInt* b) 
+{
+    STATS(BIGINT_OP_SUBTR_TO, *(a->digits) + *(b->digits));
+    __add_signed_to(dst, a, b, -b->sign);
+}
+
+void bigint_mult_to(BigInt* dst, const BigInt* a, const BigInt* b) 
+{
+    STATS(BIGINT_OP_MULT_TO, *(a->digits) + *(b->digits));
+    if (__both_small(a, b)) {
+        __set_small(dst, (uint128_t) __small_value(a->digits)
+                         * __small_value(b->digits), a->sign * b->sign);
+        return;
+    }
+
+    uint32_t len_a = *(a->digits);
+    uint32_t len_b = *(b->digits);
+
+    /*
+     * The product kernels cannot write over their operands, and a fixed
+     * dst may only have room for the trimmed product.
+     */
+    if (dst == a || dst == b
+            || (_is_borrowed(dst) && dst->cap < len_a + len_b)) {
+        BigInt tmp;
+        _borrow(&tmp, __scratch(len_a + len_b + 1), len_a + len_b);
+        bigint_mult_to(&tmp, a, b);
+        _assign(dst, &tmp);
+        __scratch_free(tmp.digits);
+        return;
+    }
+
+    /* equal values take the squaring path */
+    if (a != b && __eq(a->digits, b->digits)) b = a;
+
+    __reserve_digits(dst, len_a + len_b);
+    __mult_limbs(dst->digits + 1, a->digits + 1, len_a, b->digits + 1, len_b);
+    *(dst->digits) = __trim_limbs(dst->digits + 1, len_a + len_b);
+    _set_result(dst, a->sign * b->sign);
+}
+
+void bigint_div_to(BigInt* dst, const BigInt* n, const BigInt* d) 
+{
+    STATS(BIGINT_OP_DIV_TO, *(n->digits) + *(d->digits));
     if (__is_zero(d->digits)) {
-        fprintf(stderr, "Division by zero. Existing...\n");
+        fprintf(stderr, "Division by zero. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    if (__both_small(n, d)) {
+        __divmod_small(dst, NULL, n, d);
+        return;
+    }
+    uint32_t len_q = (*(n->digits) >= *(d->digits)) ?
+        *(n->digits) - *(d->digits) + 2 : 2;
+    if (dst == n || dst == d || (_is_borrowed(dst) && dst->cap < len_q)) {
+        BigInt tmp;
+        _borrow(&tmp, __scratch(len_q + 1), len_q);
+        __divmod_to(&tmp, NULL, n, d);
+        _assign(dst, &tmp);
+        __scratch_free(tmp.digits);
+        return;
+    }
+    __divmod_to(dst, NULL, n, d);
+}
+
+void bigint_mod_to(BigInt* dst, const BigInt* n, const BigInt* m) 
+{
+    STATS(BIGINT_OP_MOD_TO, *(n->digits) + *(m->digits));
+    if (__is_zero(m->digits)) {
+        fprintf(stderr, "Division by zero. Exiting...\n");
         exit(EXIT_FAILURE);
     }
-    if (__gt(d->digits, n->digits)) {
-        return (__same_sign(d, n)) ?
-            bigint_int_init(0) : bigint_int_init(-1);
+    if (__both_small(n, m)) {
+        __divmod_small(NULL, dst, n, m);
+        return;
     }
-    if (__is_one(d->digits)) {
-        return bigint_copy(n);
+    uint32_t len_m = *(m->digits);
+    if (dst == n || dst == m || (_is_borrowed(dst) && dst->cap < len_m)) {
+        BigInt tmp;
+        _borrow(&tmp, __scratch(len_m + 1), len_m);
+        __divmod_to(NULL, &tmp, n, m);
+        _assign(dst, &tmp);
+        __scratch_free(tmp.digits);
+        return;
     }
+    __divmod_to(NULL, dst, n, m);
+}
+
+void bigint_power_mod_to(BigInt* dst, const BigInt* b, const BigInt* e,
+                         const BigInt* m) 
+{
+    STATS(BIGINT_OP_POWER_MOD_TO, *(b->digits) + *(e->digits) + *(m->digits));
+    BigInt tmp = {.sign = 1};
+    _adopt(&tmp, __power_mod(b->digits, e->digits, m->digits));
+    _move(dst, &tmp);
+}
 
-    BigInt* res = malloc(sizeof(*res));
-    uint32_t** quorem = __divmod(n->digits, d->digits);
-    uint32_t* quotian = quorem[0];
-    uint32_t* remainder = quorem[1];
+/*
+ * dst = a + sign_b * |b|. The limb kernels go index by index, so dst
+ * may alias either operand once its buffer has been reserved.
+ */
+void __add_signed_to(BigInt* dst, const BigInt* a, const BigInt* b,
+                     int32_t sign_b) 
+{
+    if (__both_small(a, b)) {
+        uint64_t va = __small_value(a->digits);
+        uint64_t vb = __small_value(b->digits);
+        if (a->sign == sign_b)
+            __set_small(dst, (uint128_t) va + vb, sign_b);
+        else if (va >= vb)
+            __set_small(dst, va - vb, a->sign);
+        else
+            __set_small(dst, vb - va, sign_b);
+        return;
+    }
 
-    /* negative integer division */
-    if (! __same_sign(d, n) && ! __is_zero(remainder))
-        __incr(quotian);
+    uint32_t len_a = *(a->digits);
+    uint32_t len_b = *(b->digits);
+    int32_t sign = a->sign;
+    int same = (a->sign == sign_b);
+
+    /* a fixed dst may only have room for the trimmed result */
+    uint32_t len = (len_a > len_b) ? len_a + 1 : len_b + 1;
+    if (_is_borrowed(dst) && dst->cap < len) {
+        BigInt tmp;
+        _borrow(&tmp, __scratch(len + 1), len);
+        __add_signed_to(&tmp, a, b, sign_b);
+        _assign(dst, &tmp);
+        __scratch_free(tmp.digits);
+        return;
+    }
 
-    free(remainder);
-    free(quorem);
+    if (len_a < len_b || (len_a == len_b
+            && __cmp_limbs(a->digits + 1, b->digits + 1, len_a) < 0)) {
+        const BigInt* tmp = a; a = b; b = tmp;
+        uint32_t len_tmp = len_a; len_a = len_b; len_b = len_tmp;
+        if (! same) sign = sign_b;
+    }
 
-    res->digits = quotian;
-    res->sign_len = __len_decimal(quotian);
-    return (__same_sign(n, d)) ? res : _neg(res);
+    /* reserving may move the digits of an aliased operand */
+    __reserve_digits(dst, len_a);
+    uint32_t* res = dst->digits + 1;
+    uint32_t carry = 0;
+    if (same)
+        carry = __add_limbs(res, a->digits + 1, len_a, b->digits + 1, len_b);
+    else
+        __subtr_limbs(res, a->digits + 1, len_a, b->digits + 1, len_b);
+
+    if (carry) {
+        __reserve_digits(dst, len_a + 1);
+        dst->digits[len_a + 1] = carry;
+        *(dst->digits) = len_a + 1;
+    } else {
+        *(dst->digits) = __trim_limbs(dst->digits + 1, len_a);
+    }
+    _set_result(dst, sign);
 }
 
-/* true modulo as opposed to the default C remainder operation */
-BigInt* bigint_mod(BigInt* n, BigInt* m) 
+/*
+ * Floor division of n by d, the quotian goes to q and the remainder, with
+ * the sign of d, to r. One of them may be NULL, neither may alias n or d.
+ */
+void __divmod_to(BigInt* q, BigInt* r, const BigInt* n, const BigInt* d) 
 {
-    if (__is_zero(m->digits)) {
-        fprintf(stderr, "Division by zero. Existing...\n");
-        exit(EXIT_FAILURE);
+    uint32_t len_n = *(n->digits);
+    uint32_t len_d = *(d->digits);
+    uint32_t len_q = (len_n >= len_d) ? len_n - len_d + 1 : 1;
+    int negative = (n->sign != d->sign);
+    BigInt tmp = {.digits = NULL};
+
+    /* the discarded result lives in scratch */
+    if (! q || ! r) {
+        uint32_t cap = q ? len_d : len_q + 1;
+        _borrow(&tmp, __scratch(cap + 1), cap);
+        if (! q) q = &tmp;
+        else r = &tmp;
+    }
+    __reserve_digits(q, len_q + 1);
+    __reserve_digits(r, len_d);
+    uint32_t* q_d = q->digits + 1;
+    uint32_t* r_d = r->digits + 1;
+
+    if (len_n < len_d) {
+        q_d[0] = 0;
+        memcpy(r_d, n->digits + 1, len_n * sizeof(*r_d));
+        memset(r_d + len_n, 0, (len_d - len_n) * sizeof(*r_d));
+    } else {
+        __divmod_limbs(q_d, r_d, n->digits + 1, len_n, d->digits + 1, len_d);
     }
-    if (__is_one(m->digits)) {
-        return bigint_int_init(0);
+    q_d[len_q] = 0;
+
+    /* rounding towards negative infinity, q + 1 and d - r */
+    uint32_t len_r = __trim_limbs(r_d, len_d);
+    if (negative && (len_r > 1 || r_d[0])) {
+        uint32_t one = 1;
+        __add_limbs(q_d, q_d, len_q + 1, &one, 1);
+        __subtr_limbs(r_d, d->digits + 1, len_d, r_d, len_d);
     }
 
-    BigInt* res = malloc(sizeof(*res));
-    uint32_t** quorem = __divmod(n->digits, m->digits);
-    uint32_t* remainder = quorem[1];
-    free(quorem[0]);
-    free(quorem);
-    
-    res->digits = ! (__same_sign(n, m) || __is_zero(remainder)) ?
-        __subtr(m->digits, remainder) : remainder;
-    res->sign_len = __len_decimal(res->digits);
-    return (m->sign_len > 0) ? res : _neg(res);
+    *(q->digits) = __trim_limbs(q_d, len_q + 1);
+    *(r->digits) = __trim_limbs(r_d, len_d);
+    _set_result(q, negative ? -1 : 1);
+    _set_result(r, d->sign);
+    if (tmp.digits) __scratch_free(tmp.digits);
 }
 
-uint32_t bigint_hash(void* n) 
+/* __divmod_to for operands of at most INLINE_LIMBS limbs, may alias */
+void __divmod_small(BigInt* q, BigInt* r, const BigInt* n, const BigInt* d) 
 {
-    uint32_t* nd = ((BigInt*) n)->digits;
-    uint32_t res = BASE * ((BigInt*) n)->sign_len;
-    res = res << nd[*nd];
+    uint64_t vn = __small_value(n->digits);
+    uint64_t vd = __small_value(d->digits);
+    uint64_t vq = vn / vd;
+    uint64_t vr = vn % vd;
+    int negative = (n->sign != d->sign);
+
+    if (negative && vr) {
+        ++vq;
+        vr = vd - vr;
+    }
+    if (q) __set_small(q, vq, negative ? -1 : 1);
+    if (r) __set_small(r, vr, d->sign);
+}
 
-    for (int i = 1; i <= *nd; i++)
-        res = (res + 3137 * nd[i]) % 1000003;
+uint32_t bigint_hash(void* n) 
+{
+    STATS_COUNT(BIGINT_OP_HASH, *(((BigInt*) n)->digits));
+    uint64_t h = bigint_hash64(n);
+    return h ^ (h >> 32);
+}
 
-    return res;
+uint64_t bigint_hash64(const BigInt* n) 
+{
+    STATS_COUNT(BIGINT_OP_HASH64, *(n->digits));
+    return __hash_value(n);
 }
 
-int __cmp_key(void* a, void* b) 
+void bigint_hash_bulk(BigInt** ns, size_t count, uint64_t* hashes) 
 {
-    return __eq((uint32_t*) a, (uint32_t*) b);
+    STATS_COUNT(BIGINT_OP_HASH_BULK, count);
+    for (size_t i = 0; i < count; i++) {
+        /* the next handle and digits load while this one is hashed */
+        if (i + 2 < count) __builtin_prefetch(ns[i + 2]);
+        if (i + 1 < count) __builtin_prefetch(ns[i + 1]->digits);
+        hashes[i] = __hash_value(ns[i]);
+    }
 }
 
-char* __repr_keyval(void* key)
+/** the limbs of n hashed with its sign as seed */
+uint64_t __hash_value(const BigInt* n) 
 {
-    uint32_t* n = (uint32_t*) key;
-    char* res = malloc((__len_decimal(n) + 1) * sizeof(*res));
-    sprintf(res, "%u", __to_decimal(n));
-    return res;
+    return __hash_limbs(n->digits + 1, *(n->digits),
+                        (n->sign < 0) ? HASH_P3 : 0);
 }
 
-uint32_t __hash_digits(void* key) 
+/* 64x64 bit product folded to 64 bits, the mixer of wyhash */
+uint64_t __hash_mum(uint64_t a, uint64_t b) 
 {
-    uint32_t* n = (uint32_t*) key;
-    uint32_t res = *n * (BASE << *n);
-    res = res << n[*n];
+    uint128_t r = (uint128_t) a * b;
+    return (uint64_t) r ^ (uint64_t) (r >> 64);
+}
 
-    for (int i = 1; i <= *n; i++)
-        res = (res + 3137 * n[i]) % 1000003;
+/*
+ * Hashes len limbs in the manner of wyhash. Two lanes take 16 bytes each
+ * per round, so their products overlap. Values are trimmed, so equal
+ * values hash equally whether their digits are inline, on the heap or in
+ * caller storage.
+ */
+uint64_t __hash_limbs(uint32_t* limbs, uint32_t len, uint64_t seed) 
+{
+    uint64_t h0 = seed ^ HASH_P0;
+    uint64_t h1 = seed ^ HASH_P1;
+    uint32_t i = 0;
+    uint64_t w[4];
+
+    for (; i + 8 <= len; i += 8) {
+        memcpy(w, limbs + i, sizeof(w));
+        h0 = __hash_mum(w[0] ^ HASH_P1, w[1] ^ h0);
+        h1 = __hash_mum(w[2] ^ HASH_P2, w[3] ^ h1);
+    }
+    memset(w, 0, sizeof(w));
+    memcpy(w, limbs + i, (len - i) * sizeof(*limbs));
+    h0 = __hash_mum(w[0] ^ HASH_P1, w[1] ^ h0);
+    h1 = __hash_mum(w[2] ^ HASH_P2, w[3] ^ h1);
 
-    return res;
+    return __hash_mum(h0 ^ HASH_P0 ^ len, h1 ^ HASH_P3);
 }
 
 BigInt* bigint_power_mod (BigInt* base, BigInt* exp, BigInt* m) 
 {
-    BigInt* two = bigint_int_init(2);
-    BigInt* _size = bigint_log(exp, two);
-    uint32_t size = __to_decimal(_size->digits);
+    STATS(BIGINT_OP_POWER_MOD, *(base->digits) + *(exp->digits) + *(m->digits));
+    BigInt* res = _alloc();
+    bigint_power_mod_to(res, base, exp, m);
+    return res;
+}
 
-    bigint_free(&_size); bigint_free(&two);
-    HashMap* cache = hashmap_init(size, __cmp_key, __hash_digits,
-                                  __repr_keyval, __repr_keyval);
+uint32_t* __power_mod(uint32_t* base, uint32_t* exp, uint32_t* m) 
+{
+    if (__is_zero(m)) {
+        fprintf(stderr, "Division by zero. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
 
-    BigInt* res = malloc(sizeof(*res));
-    
-    uint32_t* digits = __power_mod(base->digits, exp->digits,
-                                  m->digits, cache);
-    
-    hashmap_free(&cache);
-    res->digits = digits;
-    res->sign_len = __len_decimal(digits);
+    struct BigIntModCtx* ctx = __modctx_init(m, 0);
+    uint32_t* res = __modctx_pow(ctx, base, exp);
+    __modctx_free(&ctx);
     return res;
 }
 
-uint32_t* __power_mod(uint32_t* base, uint32_t* exp,
-                      uint32_t* m, HashMap* cache) 
+BigIntModCtx* bigint_modctx_init(BigInt* m)
 {
-    if (__is_zero(m)) {
-        printf("Division by zero. Existing...\n");
+    STATS(BIGINT_OP_MODCTX_INIT, *(m->digits));
+    if (__is_zero(m->digits)) {
+        fprintf(stderr, "Division by zero. Exiting...\n");
         exit(EXIT_FAILURE);
     }
-    if (__eq(base, m) || __is_one(m))
-        return __assign_digits(0);
-    if (__is_one(base) || __is_zero(exp))
-        return __assign_digits(1);
 
-    if (__is_one(exp)) {
-        uint32_t** quorem = __divmod(base, m);
-        uint32_t* res = quorem[1];
-        free(quorem[0]); free(quorem);
-        return res;
-    } else {
-        uint32_t** quorem = __divmod(exp, U_DIGIT_TWO);
-        uint32_t* e_0 = quorem[0];
-        free(quorem[1]); free(quorem);
-        uint32_t* e_1 = __subtr(exp, e_0);
+    BigIntModCtx* ctx = __modctx_init(m->digits, 1);
+    ctx->sign = m->sign;
+    return ctx;
+}
 
-        if (! hashmap_get(cache, e_0)) {
-            uint32_t* r_0 = __power_mod(base, e_0, m, cache);
-            hashmap_insert(cache, e_0, r_0);
-        }
-        if (! hashmap_get(cache, e_1)) {
-            uint32_t* r_1 = __power_mod(base, e_1, m, cache);
-            hashmap_insert(cache, e_1, r_1);
-        }
+void bigint_modctx_free(BigIntModCtx** ctx)
+{
+    STATS_COUNT(BIGINT_OP_MODCTX_FREE, 0);
+    __modctx_free(ctx);
+}
 
-        uint32_t* prod = __mult(hashmap_get(cache, e_0),
-                                hashmap_get(cache, e_1));
-        e_0 = NULL;
-        e_1 = NULL;
-        
-        return __power_mod(prod, U_DIGIT_ONE, m, cache);
-    }    
+BigInt* bigint_mod_ctx(BigInt* n, BigIntModCtx* ctx)
+{
+    STATS(BIGINT_OP_MOD_CTX, *(n->digits));
+    uint32_t* rem = mem_malloc((ctx->len + 1) * sizeof(*rem));
+    __modctx_reduce(ctx, rem + 1, n->digits + 1, *(n->digits));
+    return __modctx_signed(ctx, rem, n->sign > 0);
 }
 
-BigInt* bigint_log(BigInt* n, BigInt* b) 
+BigInt* bigint_mulmod_ctx(BigInt* a, BigInt* b, BigIntModCtx* ctx)
+{
+    STATS(BIGINT_OP_MULMOD_CTX, *(a->digits) + *(b->digits));
+    uint32_t len_a = *(a->digits);
+    uint32_t len_b = *(b->digits);
+    uint32_t* prod = __scratch(len_a + len_b);
+    __mult_limbs(prod, a->digits + 1, len_a, b->digits + 1, len_b);
+    uint32_t* rem = mem_malloc((ctx->len + 1) * sizeof(*rem));
+    __modctx_reduce(ctx, rem + 1, prod, len_a + len_b);
+    __scratch_free(prod);
+    return __modctx_signed(ctx, rem, __same_sign(a, b));
+}
+
+BigInt* bigint_powmod_ctx(BigInt* b, BigInt* e, BigIntModCtx* ctx)
+{
+    STATS(BIGINT_OP_POWMOD_CTX, *(b->digits) + *(e->digits));
+    return _wrap(__modctx_pow(ctx, b->digits, e->digits), 1);
+}
+
+/*
+ * Wraps the remainder span of len limbs in rem + 1 into a BigInt with the
+ * sign convention of bigint_mod for a dividend of the given sign, rem is
+ * consumed.
+ */
+BigInt* __modctx_signed(struct BigIntModCtx* ctx, uint32_t* rem,
+                        int positive)
 {
-    // TODO: refactor one zero two as constant digits
-    uint32_t* zero = __assign_digits(0);
-    uint32_t* one = __assign_digits(1);
+    uint32_t len = ctx->len;
+
+    *rem = __trim_limbs(rem + 1, len);
+    if (positive != (ctx->sign > 0) && ! __is_zero(rem)) {
+        memset(rem + 1 + *rem, 0, (len - *rem) * sizeof(*rem));
+        __subtr_limbs(rem + 1, ctx->m, len, rem + 1, len);
+        *rem = __trim_limbs(rem + 1, len);
+    }
+
+    return _wrap(rem, ctx->sign);
+}
 
-    if (! __gt(n->digits, zero) || ! __gt(b->digits, one)) {
-        printf("Math domain error. Existing...\n");
+BigInt* bigint_log(BigInt* n, BigInt* b) 
+{
+    STATS(BIGINT_OP_LOG, *(n->digits) + *(b->digits));
+    if (! __gt(n->digits, U_DIGIT_ZERO) || ! __gt(b->digits, U_DIGIT_ONE)) {
+        fprintf(stderr, "Math domain error. Exiting...\n");
         exit(EXIT_FAILURE);
     }
 
-    free(zero); free(one); // TODO: once refactored removed
     if (__is_one(n->digits)) return bigint_int_init(0);
 
     // TODO: more efficient implementation 
     // gap = *nd - *bd; base = pow(b, gap);
     // return res * gap (approximately)
 
-    BigInt* res = malloc(sizeof(*res));    
-    uint32_t* quo = __copy_digits(n->digits);
-    uint32_t* exp = __assign_digits(0);
-
-    while (! __is_zero(quo)) {
-        __incr(exp);
-        uint32_t** quorem = __divmod(quo, b->digits);
-        free(quo); quo = quorem[0];
-
-        free(quorem[1]);
-        free(quorem);
+    /* divides by b in place until the quotient drops below b */
+    uint32_t len = *(n->digits);
+    uint32_t len_b = *(b->digits);
+    uint32_t* quo = __scratch(2 * len + len_b);
+    uint32_t* next = quo + len;
+    uint32_t* rem = next + len;
+    uint64_t exp = 0;
+
+    memcpy(quo, n->digits + 1, len * sizeof(*quo));
+    while (len > len_b || (len == len_b
+            && __cmp_limbs(quo, b->digits + 1, len) >= 0)) {
+        __divmod_limbs(next, rem, quo, len, b->digits + 1, len_b);
+        len = __trim_limbs(next, len - len_b + 1);
+        uint32_t* tmp = quo; quo = next; next = tmp;
+        ++exp;
     }
+    __scratch_free(quo < next ? quo : next);
 
-    __decr(exp);
-    free(quo);
-
-    res->digits = exp;
-    res->sign_len = __len_decimal(exp);
+    BigInt* res = _alloc();
+    __set_small(res, exp, 1);
     return res;
 }
 
-/**************************** BIGINT COMPARISON ****************************/ 
-
-int bigint_gt(BigInt* a, BigInt* b) 
+BigInt* bigint_abs(BigInt* n) 
 {
-    if (a->sign_len > b->sign_len) return 1;
-    if (a->sign_len == b->sign_len) {
-        if (__eq(a->digits, b->digits)) {
-            return 0;
-        } else if (a->sign_len > 0) {
-            return __st(a->digits, b->digits) ? 0 : 1;
-        } else {
-            return __gt(a->digits, b->digits) ? 0 : 1;
-        }
-    }
-    return 0;
+    STATS_COUNT(BIGINT_OP_ABS, *(n->digits));
+    BigInt* res = bigint_copy(n);
+    res->sign = 1;
+    return res;
 }
 
-int bigint_eq(BigInt* a, BigInt* b) 
+BigInt* bigint_neg(BigInt* n) 
 {
-    if (a->sign_len != b->sign_len) return 0;
-    return __eq(a->digits, b->digits);
+    STATS_COUNT(BIGINT_OP_NEG, *(n->digits));
+    BigInt* res = bigint_copy(n);
+    if (! __is_zero(res->digits)) res->sign = -n->sign;
+    return res;
 }
 
-int bigint_st(BigInt* a, BigInt* b) 
+/****************************** RESULT CACHE ******************************/
+
+BigIntCache* bigint_cache_init(size_t budget, uint64_t ops)
+{
+    STATS_COUNT(BIGINT_OP_CACHE_INIT, 0);
+    BigIntCache* cache = mem_malloc(sizeof(*cache));
+    /* the table goes through the allocator hooks, and is never printed */
+    cache->map = hashmap_init_alloc(0, __cache_eq, __cache_hash, NULL, NULL,
+                                    mem_malloc, mem_free);
+    cache->head = cache->tail = NULL;
+    cache->budget = budget;
+    cache->ops = ops;
+    memset(&cache->stats, 0, sizeof(cache->stats));
+    cache->stats.bytes = hashmap_bytes(cache->map);
+    return cache;
+}
+
+BigInt* bigint_cache_div(BigIntCache* cache, BigInt* n, BigInt* d)
+{
+    STATS(BIGINT_OP_CACHE_DIV, *(n->digits) + *(d->digits));
+    struct CacheEntry probe;
+    __cache_probe(&probe, BIGINT_OP_DIV, (BigInt*[]) {n, d}, 2);
+    struct CacheEntry* entry = __cache_find(cache, &probe);
+    if (entry) return bigint_copy(entry->res);
+
+    BigInt* res = bigint_div(n, d);
+    __cache_put(cache, &probe, res, NULL);
+    return res;
+}
+
+BigInt* bigint_cache_mod(BigIntCache* cache, BigInt* n, BigInt* m)
+{
+    STATS(BIGINT_OP_CACHE_MOD, *(n->digits) + *(m->digits));
+    struct CacheEntry probe;
+    __cache_probe(&probe, BIGINT_OP_MOD, (BigInt*[]) {n, m}, 2);
+    struct CacheEntry* entry = __cache_find(cache, &probe);
+    if (entry) return bigint_copy(entry->res);
+
+    BigInt* res = bigint_mod(n, m);
+    __cache_put(cache, &probe, res, NULL);
+    return res;
+}
+
+BigInt* bigint_cache_power_mod(BigIntCache* cache, BigInt* b, BigInt* e,
+                               BigInt* m)
+{
+    STATS(BIGINT_OP_CACHE_POWER_MOD,
+          *(b->digits) + *(e->digits) + *(m->digits));
+    struct CacheEntry probe;
+    __cache_probe(&probe, BIGINT_OP_POWER_MOD, (BigInt*[]) {b, e, m}, 3);
+    struct CacheEntry* entry = __cache_find(cache, &probe);
+    if (entry) return bigint_copy(entry->res);
+
+    BigInt* res = bigint_power_mod(b, e, m);
+    __cache_put(cache, &probe, res, NULL);
+    return res;
+}
+
+char* bigint_cache_to_str(BigIntCache* cache, BigInt* n)
+{
+    STATS(BIGINT_OP_CACHE_TO_STR, *(n->digits));
+    struct CacheEntry probe;
+    __cache_probe(&probe, BIGINT_OP_TO_STR, (BigInt*[]) {n}, 1);
+    struct CacheEntry* entry = __cache_find(cache, &probe);
+    if (entry) return __cache_str(entry->str);
+
+    char* s = bigint_to_str(n);
+    __cache_put(cache, &probe, NULL, s);
+    return s;
+}
+
+BigIntCacheStats bigint_cache_stats(BigIntCache* cache)
+{
+    STATS_COUNT(BIGINT_OP_CACHE_STATS, 0);
+    return cache->stats;
+}
+
+void bigint_cache_clear(BigIntCache* cache)
+{
+    STATS_COUNT(BIGINT_OP_CACHE_CLEAR, cache->stats.entries);
+    while (cache->head) __cache_drop(cache, cache->head);
+}
+
+void bigint_cache_free(BigIntCache** cache)
+{
+    STATS_COUNT(BIGINT_OP_CACHE_FREE, (*cache)->stats.entries);
+    bigint_cache_clear(*cache);
+    hashmap_free(&(*cache)->map);
+    mem_free(*cache);
+    *cache = NULL;
+}
+
+/**************************** BIGINT COMPARISON ****************************/ 
+
+int bigint_gt(BigInt* a, BigInt* b) 
 {
+    STATS_COUNT(BIGINT_OP_GT, *(a->digits) + *(b->digits));
+    if (a->sign != b->sign) return a->sign > b->sign;
+    return (a->sign > 0) ?
+        __gt(a->digits, b->digits) : __st(a->digits, b->digits);
+}
+
+int bigint_eq(BigInt* a, BigInt* b) 
+{
+    STATS_COUNT(BIGINT_OP_EQ, *(a->digits) + *(b->digits));
+    if (a->sign != b->sign) return 0;
+    return __eq(a->digits, b->digits);
+}
+
+int bigint_st(BigInt* a, BigInt* b) 
+{
+    STATS_COUNT(BIGINT_OP_ST, *(a->digits) + *(b->digits));
     return ! bigint_gt(a, b) && ! bigint_eq(a, b);
 }
 
@@ -438,265 +1365,1889 @@ int bigint_st(BigInt* a, BigInt* b)
 
 BigInt* bigint_copy(BigInt* n) 
 {
-    BigInt* cp_n = malloc(sizeof(*n));
-    cp_n->sign_len = n->sign_len;
-    cp_n->digits = __copy_digits(n->digits); 
+    STATS_COUNT(BIGINT_OP_COPY, *(n->digits));
+    BigInt* cp_n = _new();
+    cp_n->sign = n->sign;
+    cp_n->len_dec = __atomic_load_n(&n->len_dec, __ATOMIC_RELAXED);
+    if (*(n->digits) <= INLINE_LIMBS) {
+        _init_inline(cp_n);
+        memcpy(cp_n->small, n->digits, (*(n->digits) + 1) * sizeof(*n->digits));
+        return cp_n;
+    }
+
+    /* the storage of a fixed BigInt is not ours to share */
+    if (_is_borrowed(n)) {
+        cp_n->shared = NULL;
+        cp_n->digits = __copy_digits(n->digits);
+        cp_n->cap = *(n->digits);
+        return cp_n;
+    }
+
+    /*
+     * Heap digits are shared until either side writes. Threads copying
+     * the same BigInt race to install its counter, the losers free theirs.
+     */
+    uint32_t* shared = __atomic_load_n(&n->shared, __ATOMIC_ACQUIRE);
+    if (! shared) {
+        uint32_t* counter = mem_malloc(sizeof(*counter));
+        *counter = 1;
+        if (__atomic_compare_exchange_n(&n->shared, &shared, counter, 0,
+                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            shared = counter;
+        else
+            mem_free(counter);
+    }
+    __atomic_add_fetch(shared, 1, __ATOMIC_RELAXED);
+    cp_n->digits = n->digits;
+    cp_n->cap = n->cap;
+    cp_n->shared = shared;
     return cp_n;
 }
 
-void bigint_free(BigInt** n) 
+BigInt* bigint_ref(BigInt* n) 
+{
+    STATS_COUNT(BIGINT_OP_REF, 0);
+    if (! _is_borrowed(n)) __atomic_add_fetch(&n->refs, 1, __ATOMIC_RELAXED);
+    return n;
+}
+
+void bigint_unref(BigInt** n) 
 {
-    free((*n)->digits);
-    free(*n);
+    STATS_COUNT(BIGINT_OP_UNREF, 0);
+    if (! _is_borrowed(*n)
+            && __atomic_sub_fetch(&(*n)->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        _free_digits(*n);
+        mem_free(*n);
+    }
     *n = NULL;
 }
 
-/***************************** PRIVATE FUNCTIONS *****************************/
+void bigint_reserve(BigInt* n, size_t limbs) 
+{
+    STATS_COUNT(BIGINT_OP_RESERVE, 0);
+    if (limbs >= UINT32_MAX) {
+        fprintf(stderr, "BigInt capacity overflow. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    if (limbs > n->cap) __resize_digits(n, limbs);
+}
+
+void bigint_shrink_to_fit(BigInt* n) 
+{
+    STATS_COUNT(BIGINT_OP_SHRINK_TO_FIT, *(n->digits));
+    if (_is_inline(n) || n->shared) return;
+    if (*(n->digits) <= INLINE_LIMBS)
+        _adopt(n, n->digits);
+    else if (n->cap + 1 > __pool_size(*(n->digits) + 1))
+        __resize_digits(n, *(n->digits));
+}
+
+void bigint_free(BigInt** n) 
+{
+    STATS_COUNT(BIGINT_OP_FREE, 0);
+    bigint_unref(n);
+}
 
-/** inplace negation */
-BigInt* _neg(BigInt* n) 
+void bigint_set_allocator(void* (*malloc_fn)(size_t),
+                          void* (*realloc_fn)(void*, size_t),
+                          void (*free_fn)(void*))
 {
-    if (! __is_zero(n->digits)) {
-        n->sign_len *= -1;
+    STATS_COUNT(BIGINT_OP_SET_ALLOCATOR, 0);
+    /* other threads hand their cached blocks back on their next call */
+    __held_sync();
+    __held_release(held_free);
+    __atomic_store_n(&hook_malloc, malloc_fn ? malloc_fn : malloc,
+                     __ATOMIC_RELEASE);
+    __atomic_store_n(&hook_realloc, realloc_fn ? realloc_fn : realloc,
+                     __ATOMIC_RELEASE);
+    __atomic_store_n(&hook_free, free_fn ? free_fn : free, __ATOMIC_RELEASE);
+}
+
+void bigint_scratch_release() 
+{
+    STATS_COUNT(BIGINT_OP_SCRATCH_RELEASE, 0);
+    __scratch_release();
+}
+
+size_t bigint_pool_occupancy(size_t* buffers) 
+{
+    STATS_COUNT(BIGINT_OP_POOL_OCCUPANCY, 0);
+    size_t bytes = 0;
+    size_t count = 0;
+    for (uint32_t k = 0; k < POOL_CLASSES; k++) {
+        bytes += (size_t) pool.count[k] << (k + POOL_MIN_CLASS);
+        count += pool.count[k];
+    }
+    if (buffers) *buffers = count;
+    return bytes * sizeof(uint32_t);
+}
+
+void bigint_pool_trim() 
+{
+    STATS_COUNT(BIGINT_OP_POOL_TRIM, 0);
+    __held_sync();
+    for (uint32_t k = 0; k < POOL_CLASSES; k++) {
+        while (pool.head[k]) {
+            uint32_t* digits = pool.head[k];
+            memcpy(&pool.head[k], digits, sizeof(pool.head[k]));
+            mem_free(digits);
+        }
+        pool.count[k] = 0;
+    }
+}
+
+BigIntStats bigint_stats_snapshot() 
+{
+    BigIntStats snapshot;
+    uint64_t* from = (uint64_t*) &stats;
+    uint64_t* to = (uint64_t*) &snapshot;
+    for (size_t i = 0; i < sizeof(stats) / sizeof(*from); i++)
+        to[i] = __atomic_load_n(&from[i], __ATOMIC_RELAXED);
+    return snapshot;
+}
+
+void bigint_stats_reset() 
+{
+    for (int op = 0; op < BIGINT_OPS; op++) {
+        __atomic_store_n(&stats.ops[op].calls, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&stats.ops[op].limbs, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&stats.ops[op].nanos, 0, __ATOMIC_RELAXED);
     }
+    __atomic_store_n(&stats.mallocs, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats.reallocs, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats.frees, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats.bytes_peak,
+        __atomic_load_n(&stats.bytes_live, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+}
+
+const char* bigint_stats_name(int op) 
+{
+    return (op >= 0 && op < BIGINT_OPS) ? stats_names[op] : NULL;
+}
+
+/***************************** PRIVATE FUNCTIONS *****************************/
+
+/** wraps a digit array into a BigInt of the given sign */
+BigInt* _wrap(uint32_t* digits, int32_t sign) 
+{
+    BigInt* n = _new();
+    _adopt(n, digits);
+    _set_result(n, sign);
     return n;
 }
 
-int __same_sign(BigInt* a, BigInt* b) 
+/** a zero BigInt in inline storage, to be filled by a destination operation */
+BigInt* _alloc() 
 {
-    return (a->sign_len > 0 && b->sign_len > 0) || 
-           (a->sign_len < 0 && b->sign_len < 0);
+    BigInt* n = _new();
+    _init_inline(n);
+    n->sign = 1;
+    n->len_dec = 0;
+    return n;
 }
 
-/**
- * Upper-bound exclusive.
+/** a BigInt handle holding a single reference, its fields unset */
+BigInt* _new() 
+{
+    BigInt* n = mem_malloc(sizeof(*n));
+    n->refs = 1;
+    n->shared = NULL;
+    return n;
+}
+
+/** gives n a digit buffer of its own before it is written */
+void _unshare(BigInt* n) 
+{
+    if (__atomic_load_n(n->shared, __ATOMIC_ACQUIRE) == 1) {
+        mem_free(n->shared);
+        n->shared = NULL;
+        return;
+    }
+    uint32_t* digits = __pool_get((size_t) n->cap + 1);
+    memcpy(digits, n->digits, (*(n->digits) + 1) * sizeof(*digits));
+    _free_digits(n);
+    n->digits = digits;
+}
+
+/** moves the value of src into dst, freeing the digits of dst */
+void _move(BigInt* dst, BigInt* src) 
+{
+    if (_is_borrowed(dst)) {
+        _assign(dst, src);
+        _free_digits(src);
+        return;
+    }
+    uint32_t refs = dst->refs;
+    _free_digits(dst);
+    *dst = *src;
+    dst->refs = refs;
+    if (_is_inline(src)) dst->digits = dst->small;
+}
+
+/** copies the value of src into the digits of dst */
+void _assign(BigInt* dst, BigInt* src) 
+{
+    __reserve_digits(dst, *(src->digits));
+    memcpy(dst->digits, src->digits, (*(src->digits) + 1) * sizeof(*src->digits));
+    dst->sign = src->sign;
+    dst->len_dec = src->len_dec;
+}
+
+/** points n at zero in the borrowed buffer digits of cap limbs */
+void _borrow(BigInt* n, uint32_t* digits, uint32_t cap) 
+{
+    n->sign = 1;
+    n->len_dec = 0;
+    n->digits = digits;
+    n->cap = cap;
+    n->shared = &borrowed;
+    digits[0] = 1;
+    digits[1] = 0;
+}
+
+/*
+ * The allocator of the library. A BIGINT_STATS build prefixes every
+ * allocation with its size, so frees know how many bytes they return.
  */
-uint32_t* __slice_digits(uint32_t* n, int start, int end) 
+void* mem_malloc(size_t size) 
 {
-    assert(end >= start);
-    assert(start >= 1 && end <= *(n) + 1);
+#ifdef BIGINT_STATS
+    char* p = HOOK(malloc)(size + STATS_HEADER);
+    if (! p) return NULL;
+    memcpy(p, &size, sizeof(size));
+    __atomic_add_fetch(&stats.mallocs, 1, __ATOMIC_RELAXED);
+    __stats_alloc(size);
+    return p + STATS_HEADER;
+#else
+    return HOOK(malloc)(size);
+#endif
+}
 
-    uint32_t* digits = malloc((end - start + 1) * sizeof(*digits));
-    *digits = end - start;
-    for (int i = start; i < end; i++) {
-        digits[i - start + 1] = n[i];
+void* mem_realloc(void* p, size_t size) 
+{
+#ifdef BIGINT_STATS
+    if (! p) return mem_malloc(size);
+    size_t old;
+    char* q = (char*) p - STATS_HEADER;
+    memcpy(&old, q, sizeof(old));
+    q = HOOK(realloc)(q, size + STATS_HEADER);
+    if (! q) return NULL;
+    memcpy(q, &size, sizeof(size));
+    __atomic_add_fetch(&stats.reallocs, 1, __ATOMIC_RELAXED);
+    __stats_alloc((int64_t) size - (int64_t) old);
+    return q + STATS_HEADER;
+#else
+    return HOOK(realloc)(p, size);
+#endif
+}
+
+void mem_free(void* p) 
+{
+    __mem_free_with(p, HOOK(free));
+}
+
+/** frees p of mem_malloc through free_fn, the allocator it came from */
+void __mem_free_with(void* p, void (*free_fn)(void*)) 
+{
+#ifdef BIGINT_STATS
+    if (! p) return;
+    size_t size;
+    char* q = (char*) p - STATS_HEADER;
+    memcpy(&size, q, sizeof(size));
+    __atomic_add_fetch(&stats.frees, 1, __ATOMIC_RELAXED);
+    __stats_alloc(-(int64_t) size);
+    free_fn(q);
+#else
+    free_fn(p);
+#endif
+}
+
+/** counts and, if timed, times a public call unless it is nested */
+struct StatsCall __stats_begin(int op, uint64_t limbs, int timed) 
+{
+    struct StatsCall call = {.op = -1};
+    if (stats_depth++) return call;
+    __atomic_add_fetch(&stats.ops[op].calls, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats.ops[op].limbs, limbs, __ATOMIC_RELAXED);
+    if (! timed) return call;
+    call.op = op;
+    call.start = __stats_now();
+    return call;
+}
+
+void __stats_end(struct StatsCall* call) 
+{
+    --stats_depth;
+    if (call->op < 0) return;
+    __atomic_add_fetch(&stats.ops[call->op].nanos,
+                       __stats_now() - call->start, __ATOMIC_RELAXED);
+}
+
+/** adds bytes to the live bytes, raising the peak */
+void __stats_alloc(int64_t bytes) 
+{
+    uint64_t live = __atomic_add_fetch(&stats.bytes_live, (uint64_t) bytes,
+                                       __ATOMIC_RELAXED);
+    uint64_t peak = __atomic_load_n(&stats.bytes_peak, __ATOMIC_RELAXED);
+    while (live > peak && ! __atomic_compare_exchange_n(&stats.bytes_peak,
+            &peak, live, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+uint64_t __stats_now() 
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/** sets the sign of freshly computed digits, zero is positive */
+void _set_result(BigInt* n, int32_t sign) 
+{
+    n->sign = __is_zero(n->digits) ? 1 : sign;
+    n->len_dec = 0;
+}
+
+/** points the digits of n at its inline buffer, holding zero */
+void _init_inline(BigInt* n) 
+{
+    n->shared = NULL;
+    n->digits = n->small;
+    n->cap = INLINE_LIMBS;
+    n->small[0] = 1;
+    n->small[1] = 0;
+}
+
+/** hands a heap digit array to n, small values are copied inline */
+void _adopt(BigInt* n, uint32_t* digits) 
+{
+    n->shared = NULL;
+    if (*digits <= INLINE_LIMBS) {
+        memcpy(n->small, digits, (*digits + 1) * sizeof(*digits));
+        __free_digits(digits);
+        n->digits = n->small;
+        n->cap = INLINE_LIMBS;
+    } else {
+        n->digits = digits;
+        n->cap = *digits;
     }
+}
 
-    return digits;
+/*
+ * Frees the digit buffer of n unless it is the inline one, a shared
+ * buffer only loses a sharer until the last one lets go.
+ */
+void _free_digits(BigInt* n) 
+{
+    if (_is_inline(n) || _is_borrowed(n) || ! n->digits) return;
+    if (n->shared) {
+        uint32_t* shared = n->shared;
+        n->shared = NULL;
+        if (__atomic_sub_fetch(shared, 1, __ATOMIC_ACQ_REL) > 0) return;
+        mem_free(shared);
+    }
+    __pool_put(n->digits, n->cap + 1);
 }
 
-/**
- * Right shifting digits, equivalent to multiply by base.
+int _is_inline(BigInt* n) 
+{
+    return n->digits == n->small;
+}
+
+/* read atomically, bigint_copy may be installing a counter meanwhile */
+int _is_borrowed(BigInt* n) 
+{
+    return __atomic_load_n(&n->shared, __ATOMIC_RELAXED) == &borrowed;
+}
+
+/* Both magnitudes fit INLINE_LIMBS limbs, below 2^64 in either base */
+int __both_small(const BigInt* a, const BigInt* b) 
+{
+    return *(a->digits) <= INLINE_LIMBS && *(b->digits) <= INLINE_LIMBS;
+}
+
+uint64_t __small_value(uint32_t* digits) 
+{
+    uint64_t v = digits[1];
+    if (*digits > 1) v += (uint64_t) digits[2] * BASE;
+    return v;
+}
+
+/*
+ * Writes the value v (below BASE^4) with the given sign into n. The
+ * operands are read before the call, so n may alias either of them.
  */
-uint32_t* __right_shift(uint32_t* n) 
+void __set_small(BigInt* n, uint128_t v, int32_t sign) 
 {
-    if (__is_zero(n)) return __assign_digits(0);
-    int len = *(n) + 1;
-    uint32_t* digits = malloc((len + 1) * sizeof(*digits));
-    *digits = len;
-    digits[1] = 0;
-    for (int i = 1; i <= *(n); i++)
-        digits[i + 1] = n[i];
-    return digits;    
+    uint32_t limbs[4];
+    uint32_t len = 0;
+
+    for (; v >> 64; v /= BASE) limbs[len++] = v % BASE;
+    uint64_t w = v;
+    do {
+        limbs[len++] = w % BASE;
+        w /= BASE;
+    } while (w);
+
+    __reserve_digits(n, len);
+    memcpy(n->digits + 1, limbs, len * sizeof(*limbs));
+    *(n->digits) = len;
+    _set_result(n, sign);
 }
 
-/***************************** UNSIGNED OPERATIONS *****************************/
+/*
+ * Makes room for len limbs in the digit buffer of n, keeping its digits.
+ * The buffer grows by at least half its size, so results that creep up
+ * a limb at a time reallocate O(log n) times. Every write to the digits
+ * of a BigInt reserves first, which is where a shared buffer is cloned.
+ */
+void __reserve_digits(BigInt* n, uint32_t len) 
+{
+    if (n->shared && ! _is_borrowed(n)) _unshare(n);
+    if (n->cap >= len) return;
+    uint32_t cap = n->cap + n->cap / 2;
+    __resize_digits(n, (cap > len) ? cap : len);
+}
 
-// base conversion to 30 bit (actual: 10**9);
-uint32_t* __to_base_giga(char* sn, int32_t len) 
+/*
+ * Moves the digits of n to a buffer of cap limbs, rounded up to its pool
+ * size class, leaving the inline buffer if need be (cap > INLINE_LIMBS).
+ * Buffers beyond the largest class are reallocated in place.
+ */
+void __resize_digits(BigInt* n, uint32_t cap) 
 {
-    if (sn[0] == '-') ++sn;
+    if (_is_borrowed(n)) {
+        fprintf(stderr, "BigInt fixed capacity exceeded. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t words = __pool_size((size_t) cap + 1);
+    size_t pooled = (size_t) 1 << POOL_MAX_CLASS;
+    uint32_t* digits;
 
-    // store len of digits at idx 0
-    uint32_t len_digits = len / (LEN_BASE);
-    if (len % LEN_BASE) ++len_digits;
-    uint32_t* digits = malloc((len_digits + 1) * sizeof(*digits)); 
+    if (words > pooled && n->cap + 1 > pooled && ! _is_inline(n)
+            && ! n->shared) {
+        digits = mem_realloc(n->digits, words * sizeof(*digits));
+        if (! digits) {
+            fprintf(stderr, "Out of memory. Exiting...\n");
+            exit(EXIT_FAILURE);
+        }
+    } else {
+        digits = __pool_get(words);
+        if (n->digits) {
+            uint32_t keep = (n->cap < cap) ? n->cap : cap;
+            memcpy(digits, n->digits, (keep + 1) * sizeof(*digits));
+        }
+        _free_digits(n);
+    }
+    n->digits = digits;
+    n->cap = words - 1;
+}
 
-    if (len_digits == 1) {
-        *digits = 1;
-        *(digits + 1) = atoi(sn);
-        return digits;
+/*
+ * Bumps a span of len limbs off the scratch arena of the calling thread.
+ * Spans must be given back with __scratch_free, latest first.
+ */
+uint32_t* __scratch(size_t len) 
+{
+    /* an empty span still takes a limb, so it lies inside its block */
+    if (! len) len = 1;
+    struct ScratchBlock* b = scratch.block;
+    if (b && scratch.top + len <= b->cap) {
+        scratch.top += len;
+        return b->limbs + scratch.top - len;
     }
-    
-    uint32_t* cur_digit = digits + 1;
-    int s_place = 0;
-    int mult = 1;
-    *digits = 1;
-    *cur_digit = 0;
 
-    for (int i = len - 1; i >= 0; i--) {
-        uint32_t n_i = sn[i] - '0';
-        *cur_digit += n_i * mult;
-        mult *= 10;
-        ++s_place;
-        if (i > 0 && s_place % LEN_BASE == 0) {
-            ++cur_digit;
-            *cur_digit = 0;
-            mult = 1;
-            ++*digits;
+    if (! b) __held_sync();
+
+    /* continue in the next block, the blocks after it are all unused */
+    struct ScratchBlock* next = b ? b->next : scratch.head;
+    if (! next || next->cap < len) {
+        while (next) {
+            struct ScratchBlock* after = next->next;
+            mem_free(next);
+            next = after;
         }
+        size_t cap = b ? 2 * b->cap : scratch.hint;
+        if (cap < SCRATCH_BLOCK) cap = SCRATCH_BLOCK;
+        if (cap < len) cap = len;
+        next = mem_malloc(sizeof(*next) + cap * sizeof(*next->limbs));
+        if (! next) {
+            fprintf(stderr, "Out of memory. Exiting...\n");
+            exit(EXIT_FAILURE);
+        }
+        next->prev = b;
+        next->next = NULL;
+        next->cap = cap;
+        if (b) b->next = next;
+        else scratch.head = next;
     }
-    return digits;
+    scratch.block = next;
+    scratch.top = len;
+    return next->limbs;
 }
 
-uint32_t* __assign_digits(uint32_t n) 
+uint32_t* __scratch_zero(size_t len) 
 {
-    int len = (n < BASE) ? 1 : 2; // max(uint32_t) < 4*BASE
-    uint32_t* digits = malloc((len+1) * sizeof(*digits));
-    *digits = len;
-    if (len == 1) {
-        digits[1] = n;
-    } else {
-        digits[1] = n % BASE;
-        digits[2] = n / BASE;
+    uint32_t* span = __scratch(len);
+    memset(span, 0, len * sizeof(*span));
+    return span;
+}
+
+/*
+ * Gives span and every span bumped after it back to the arena. Once the
+ * arena is empty a chain of blocks is merged, so the next operation of
+ * the same size is served by a single block.
+ */
+void __scratch_free(uint32_t* span) 
+{
+    struct ScratchBlock* b = scratch.block;
+    assert(b);
+    while (span < b->limbs || span >= b->limbs + b->cap) {
+        b = b->prev;
+        assert(b);
     }
-    return digits;
+    /* spans are freed latest first, so span is still in use */
+    assert(b != scratch.block || span < b->limbs + scratch.top);
+
+    if (span == b->limbs && ! b->prev) {
+        size_t total = 0;
+        for (struct ScratchBlock* c = scratch.head; c; c = c->next)
+            total += c->cap;
+        if (scratch.head->next) {
+            __scratch_release();
+            scratch.hint = total;
+            return;
+        }
+        scratch.block = NULL;
+        scratch.top = 0;
+        return;
+    }
+    scratch.block = b;
+    scratch.top = span - b->limbs;
 }
 
-uint32_t __to_decimal(uint32_t* n) 
+/** returns every block of the arena of the calling thread */
+void __scratch_release() 
 {
-    return (*n == 1) ?
-        n[1] : n[2] * BASE + n[1];
+    __held_sync();
+    struct ScratchBlock* b = scratch.head;
+    while (b) {
+        struct ScratchBlock* next = b->next;
+        mem_free(b);
+        b = next;
+    }
+    scratch.head = NULL;
+    scratch.block = NULL;
+    scratch.top = 0;
+    scratch.hint = 0;
+}
+
+/** the number of words __pool_get hands out for a request of words */
+size_t __pool_size(size_t words) 
+{
+    size_t size = (size_t) 1 << POOL_MIN_CLASS;
+    if (words > ((size_t) 1 << POOL_MAX_CLASS)) return words;
+    while (size < words) size <<= 1;
+    return size;
+}
+
+/*
+ * A digit array of at least words words, taken from the cache of the
+ * calling thread when its size class has a free one.
+ */
+uint32_t* __pool_get(size_t words) 
+{
+    __held_sync();
+    size_t size = __pool_size(words);
+    uint32_t k = 0;
+    while (k < POOL_CLASSES && ((size_t) 1 << (k + POOL_MIN_CLASS)) < size)
+        ++k;
+
+    uint32_t* digits;
+    if (k < POOL_CLASSES && pool.head[k]) {
+        digits = pool.head[k];
+        memcpy(&pool.head[k], digits, sizeof(pool.head[k]));
+        --pool.count[k];
+        return digits;
+    }
+
+    digits = mem_malloc(size * sizeof(*digits));
+    if (! digits) {
+        fprintf(stderr, "Out of memory. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    return digits;
+}
+
+/*
+ * Gives back a digit array of words words, it joins the largest size
+ * class it covers unless that class is full or out of range.
+ */
+void __pool_put(uint32_t* digits, size_t words) 
+{
+    __held_sync();
+    if (words < ((size_t) 1 << POOL_MIN_CLASS)) {
+        mem_free(digits);
+        return;
+    }
+    uint32_t k = 0;
+    while (k < POOL_CLASSES && ((size_t) 2 << (k + POOL_MIN_CLASS)) <= words)
+        ++k;
+    if (k >= POOL_CLASSES || pool.count[k] >= POOL_CACHE) {
+        mem_free(digits);
+        return;
+    }
+
+    memcpy(digits, &pool.head[k], sizeof(pool.head[k]));
+    pool.head[k] = digits;
+    ++pool.count[k];
+}
+
+/*
+ * Hands the blocks of the arena and pool of the calling thread back to
+ * the allocator they came from if it has been replaced since. Waits for
+ * the arena to be empty, no span of it may be in use.
+ */
+void __held_sync() 
+{
+    void (*free_fn)(void*) = HOOK(free);
+    if (held_free == free_fn || scratch.block) return;
+    if (held_free) __held_release(held_free);
+    held_free = free_fn;
+}
+
+/** frees the blocks of the arena and pool of the calling thread */
+void __held_release(void (*free_fn)(void*)) 
+{
+    struct ScratchBlock* b = scratch.head;
+    while (b) {
+        struct ScratchBlock* next = b->next;
+        __mem_free_with(b, free_fn);
+        b = next;
+    }
+    memset(&scratch, 0, sizeof(scratch));
+    for (uint32_t k = 0; k < POOL_CLASSES; k++) {
+        while (pool.head[k]) {
+            uint32_t* digits = pool.head[k];
+            memcpy(&pool.head[k], digits, sizeof(pool.head[k]));
+            __mem_free_with(digits, free_fn);
+        }
+        pool.count[k] = 0;
+    }
+}
+
+/** gives back a digit array known to hold its limb count plus one words */
+void __free_digits(uint32_t* digits) 
+{
+    __pool_put(digits, (size_t) *digits + 1);
+}
+
+int __same_sign(BigInt* a, BigInt* b) 
+{
+    return a->sign == b->sign;
+}
+
+/**
+ * Upper-bound exclusive.
+ */
+uint32_t* __slice_digits(uint32_t* n, int start, int end) 
+{
+    assert(end >= start);
+    assert(start >= 1 && end <= *(n) + 1);
+
+    uint32_t* digits = __pool_get(end - start + 1);
+    *digits = end - start;
+    for (int i = start; i < end; i++) {
+        digits[i - start + 1] = n[i];
+    }
+
+    return digits;
+}
+
+/**
+ * Right shifting digits, equivalent to multiply by base.
+ */
+uint32_t* __right_shift(uint32_t* n) 
+{
+    if (__is_zero(n)) return __assign_digits(0);
+    int len = *(n) + 1;
+    uint32_t* digits = mem_malloc((len + 1) * sizeof(*digits));
+    *digits = len;
+    digits[1] = 0;
+    for (int i = 1; i <= *(n); i++)
+        digits[i + 1] = n[i];
+    return digits;    
+}
+
+/***************************** UNSIGNED OPERATIONS *****************************/
+
+// base conversion to 30 bit (actual: 10**9);
+uint32_t* __to_base_giga(char* sn, int32_t len) 
+{
+    if (sn[0] == '-') ++sn;
+
+    // store len of digits at idx 0
+    uint32_t len_digits = len / (LEN_BASE);
+    if (len % LEN_BASE) ++len_digits;
+    uint32_t* digits = mem_malloc((len_digits + 1) * sizeof(*digits)); 
+
+    if (len_digits == 1) {
+        *digits = 1;
+        *(digits + 1) = atoi(sn);
+        return digits;
+    }
+    
+    uint32_t* cur_digit = digits + 1;
+    int s_place = 0;
+    int mult = 1;
+    *digits = 1;
+    *cur_digit = 0;
+
+    for (int i = len - 1; i >= 0; i--) {
+        uint32_t n_i = sn[i] - '0';
+        *cur_digit += n_i * mult;
+        mult *= 10;
+        ++s_place;
+        if (i > 0 && s_place % LEN_BASE == 0) {
+            ++cur_digit;
+            *cur_digit = 0;
+            mult = 1;
+            ++*digits;
+        }
+    }
+    return digits;
+}
+
+#ifdef BIGINT_BINARY_LIMBS
+/*
+ * Converts base 10^9 digits, as parsed by __to_base_giga, into binary
+ * limbs. Both halves of the chunks are converted recursively and joined
+ * with one product by a power of 10^9, which keeps the conversion as fast
+ * as the multiplication.
+ */
+uint32_t* __giga_to_limbs(uint32_t* giga)
+{
+    uint32_t len = *giga;
+    uint32_t** pw = __giga_powers(len);
+    uint32_t* digits = mem_malloc((len + 1) * sizeof(*digits));
+    *digits = __giga_to_limbs_dc(digits + 1, giga + 1, len, pw);
+    __giga_powers_free(pw);
+    return digits;
+}
+
+/*
+ * Converts binary limbs into base 10^9 digits for printing, the inverse
+ * of __giga_to_limbs by division through the same powers.
+ */
+uint32_t* __limbs_to_giga(uint32_t* n)
+{
+    /* bits * log10(2) / 9 chunks, rounded up */
+    uint64_t bits = 32 * (uint64_t) *n;
+    uint32_t len_g = bits * 30103 / (100000 * LEN_BASE) + 1;
+    uint32_t** pw = __giga_powers(len_g);
+    uint32_t* digits = mem_malloc((len_g + 1) * sizeof(*digits));
+    __limbs_to_giga_dc(digits + 1, len_g, n + 1, *n, pw);
+    *digits = __trim_limbs(digits + 1, len_g);
+    __giga_powers_free(pw);
+    return digits;
+}
+
+/*
+ * Returns the binary powers (10^9)^(2^k) for every 2^k below len, each as
+ * a digit array, the table ends with NULL.
+ */
+uint32_t** __giga_powers(uint32_t len)
+{
+    uint32_t levels = 0;
+    while (len > CONV_THRESHOLD && levels < 32 && (1u << levels) < len)
+        ++levels;
+
+    uint32_t** pw = mem_malloc((levels + 1) * sizeof(*pw));
+    for (uint32_t k = 0; k < levels; k++) {
+        pw[k] = (k == 0) ?
+            __assign_digits(GIGA) : __mult(pw[k - 1], pw[k - 1]);
+    }
+    pw[levels] = NULL;
+    return pw;
+}
+
+void __giga_powers_free(uint32_t** pw)
+{
+    for (uint32_t** p = pw; *p; p++) mem_free(*p);
+    mem_free(pw);
+}
+
+/*
+ * Writes the value of the len base 10^9 chunks g to res as binary limbs
+ * and returns their number. The value is below 2^(32 len), so res needs
+ * len limbs.
+ */
+uint32_t __giga_to_limbs_dc(uint32_t* res, uint32_t* g, uint32_t len,
+                            uint32_t** pw)
+{
+    if (len <= CONV_THRESHOLD) {
+        uint32_t len_res = 1;
+        res[0] = 0;
+        for (uint32_t i = len; i > 0; i--) {
+            uint64_t carry = g[i - 1];
+            for (uint32_t j = 0; j < len_res; j++) {
+                carry += (uint64_t) res[j] * GIGA;
+                res[j] = carry % BASE;
+                carry /= BASE;
+            }
+            if (carry) res[len_res++] = carry;
+        }
+        return len_res;
+    }
+
+    /* value = hi * (10^9)^h + lo with h the largest power of two below len */
+    uint32_t k = 0;
+    while ((2u << k) < len) ++k;
+    uint32_t h = 1u << k;
+    uint32_t* d = pw[k] + 1;
+    uint32_t len_d = *pw[k];
+
+    uint32_t* lo = __scratch(len);
+    uint32_t* hi = lo + h;
+    uint32_t len_lo = __giga_to_limbs_dc(lo, g, h, pw);
+    uint32_t len_hi = __giga_to_limbs_dc(hi, g + h, len - h, pw);
+
+    __mult_limbs(res, hi, len_hi, d, len_d);
+    memset(res + len_hi + len_d, 0, (len - len_hi - len_d) * sizeof(*res));
+    __add_limbs(res, res, len, lo, len_lo);
+    __scratch_free(lo);
+    return __trim_limbs(res, len);
+}
+
+/*
+ * Writes the len limbs n as len_g base 10^9 chunks to g, zero padded, for
+ * n below (10^9)^len_g.
+ */
+void __limbs_to_giga_dc(uint32_t* g, uint32_t len_g, uint32_t* n,
+                        uint32_t len, uint32_t** pw)
+{
+    if (len_g <= CONV_THRESHOLD) {
+        uint32_t* t = __scratch(len);
+        memcpy(t, n, len * sizeof(*t));
+        for (uint32_t i = 0; i < len_g; i++) {
+            g[i] = __divmod_limb(t, t, len, GIGA);
+            len = __trim_limbs(t, len);
+        }
+        __scratch_free(t);
+        return;
+    }
+
+    uint32_t k = 0;
+    while ((2u << k) < len_g) ++k;
+    uint32_t h = 1u << k;
+    uint32_t* d = pw[k] + 1;
+    uint32_t len_d = *pw[k];
+
+    if (len < len_d) {
+        __limbs_to_giga_dc(g, h, n, len, pw);
+        memset(g + h, 0, (len_g - h) * sizeof(*g));
+        return;
+    }
+
+    uint32_t len_q = len - len_d + 1;
+    uint32_t* q = __scratch(len_q + len_d);
+    uint32_t* r = q + len_q;
+    __divmod_limbs(q, r, n, len, d, len_d);
+    __limbs_to_giga_dc(g, h, r, __trim_limbs(r, len_d), pw);
+    __limbs_to_giga_dc(g + h, len_g - h, q, __trim_limbs(q, len_q), pw);
+    __scratch_free(q);
+}
+#endif
+
+uint32_t* __assign_digits(uint32_t n) 
+{
+    int len = (n < BASE) ? 1 : 2; // max(uint32_t) < 4*BASE
+    uint32_t* digits = __pool_get(len + 1);
+    *digits = len;
+    if (len == 1) {
+        digits[1] = n;
+    } else {
+        digits[1] = n % BASE;
+        digits[2] = n / BASE;
+    }
+    return digits;
+}
+
+uint32_t __to_decimal(uint32_t* n) 
+{
+    return (*n == 1) ?
+        n[1] : n[2] * BASE + n[1];
+}
+
+int __gt(uint32_t* a, uint32_t* b) 
+{
+    if (*(a) > *(b)) return 1;
+    if (*(a) == *(b)) {
+        int i = *(a);
+        while (i > 0) {
+            if (a[i] > b[i]) return 1;
+            if (a[i] < b[i]) return 0;
+            --i;
+        }
+    }
+    return 0;
+}
+
+int __eq(uint32_t* a, uint32_t* b) 
+{
+    if (*(a) != *(b)) return 0;
+    int i = *(a);
+    while (i > 0) {
+        if (a[i] != b[i]) return 0;
+        --i;
+    }
+    return 1;
+}
+
+int __st(uint32_t* a, uint32_t* b) 
+{
+    return ! __gt(a, b) && ! __eq(a, b);
+}
+
+/*
+ * Inplace increment, returns n, which moves when the carry adds a limb.
+ * n must not be read by other threads meanwhile.
+ */
+uint32_t* __incr(uint32_t* n) 
+{
+    for (int i = 1; i <= *n; i++) {
+        if (n[i] < BASE - 1) {
+            n[i] += 1;
+            return n;
+        } else {
+            n[i] = 0;
+        }
+    }
+
+    n = mem_realloc(n, (*n + 2) * sizeof(*n));
+    ++*n;
+    n[*n] = 1;
+    return n;
+}
+
+/*
+ * Inplace decrement, halt at zero. n must not be read by other threads
+ * meanwhile.
+ */
+void __decr(uint32_t* n) 
+{
+    if (__is_zero(n)) return;
+
+    for (int i = 1; i <= *n; i++) {
+        if (n[i] >= 1) {
+            n[i] -= 1;
+            if (i > 1 && i == *n && n[i] == 0) --*n;
+            return;
+        } else {
+            n[i] = BASE - 1;
+        }
+    }
+}
+
+int __is_zero(uint32_t* n) 
+{
+    return *(n) == 1 && n[1] == 0 ? 1 : 0;
+}
+
+int __is_one(uint32_t* n) 
+{
+    return *(n) == 1 && n[1] == 1 ? 1 : 0;
+}
+
+uint32_t* __copy_digits(uint32_t* n) 
+{
+    int32_t len = *(n) + 1; 
+    uint32_t* cp_n = __pool_get(len);
+    memcpy(cp_n, n, len * sizeof(*cp_n));
+    *(cp_n) = *(n);
+    return cp_n;
+}
+
+/*
+ * Returns the number of decimal digits.
+ */
+uint32_t __len_decimal(uint32_t* digits) 
+{
+    int32_t len_msb = 0;
+    uint32_t msb = digits[*digits];    
+
+    if (msb == 0) return 1;
+
+    while (msb > 0) {
+        msb /= 10;
+        ++len_msb;
+    }
+    
+    return len_msb + LEN_BASE * (*digits - 1);
+}
+
+
+/*
+ * Returns the argument with greater digits length
+ */
+uint32_t* __arg_len_max(uint32_t* a, uint32_t* b) 
+{
+    return *(a) > *(b) ? a : b;
+}
+
+/*
+ * Returns the argument with lesser digits length
+ */
+uint32_t* __arg_len_min(uint32_t* a, uint32_t* b) 
+{
+    return *(a) < *(b) ? a : b;
+}
+
+uint32_t* __mult(uint32_t* a, uint32_t* b) 
+{
+    if (__is_one(a)) return __copy_digits(b);
+    if (__is_one(b)) return __copy_digits(a);
+
+    /* identical operands take the squaring path of the kernels */
+    if (a != b && __eq(a, b)) b = a;
+
+    uint32_t len = *(a) + *(b);
+    uint32_t* digits = mem_malloc((len + 1) * sizeof(*digits));
+
+    __mult_limbs(digits + 1, a + 1, *(a), b + 1, *(b));
+
+    while (len > 1 && digits[len] == 0) --len;
+    *digits = len;
+    return digits;
+}
+
+/***************************** LIMB KERNELS *****************************/
+
+/*
+ * The kernels below work on bare limb spans (no length prefix) so that
+ * the recursive multiplication can address halves of an operand without
+ * copying them. Spans are little-endian, like the digit arrays.
+ */
+
+/*
+ * res = a + b, where len_a >= len_b. res holds len_a limbs and may
+ * alias a. Returns the carry out of the top limb.
+ */
+uint32_t __add_limbs(uint32_t* res, uint32_t* a, uint32_t len_a,
+                     uint32_t* b, uint32_t len_b)
+{
+    uint64_t carry = 0;
+    uint32_t i = 0;
+
+    for (; i < len_b; i++) {
+        carry += (uint64_t) a[i] + b[i];
+        res[i] = (carry >= BASE) ? carry - BASE : carry;
+        carry = (carry >= BASE);
+    }
+    for (; i < len_a; i++) {
+        carry += a[i];
+        res[i] = (carry >= BASE) ? carry - BASE : carry;
+        carry = (carry >= BASE);
+    }
+    return carry;
+}
+
+/*
+ * res = a - b, where len_a >= len_b. res holds len_a limbs and may
+ * alias a. Returns the borrow out of the top limb.
+ */
+uint32_t __subtr_limbs(uint32_t* res, uint32_t* a, uint32_t len_a,
+                       uint32_t* b, uint32_t len_b)
+{
+    uint32_t borrow = 0;
+    uint32_t i = 0;
+
+    for (; i < len_b; i++) {
+        uint64_t sub = (uint64_t) b[i] + borrow;
+        borrow = a[i] < sub;
+        res[i] = a[i] + (borrow ? BASE : 0) - sub;
+    }
+    for (; i < len_a; i++) {
+        uint32_t a_i = a[i];
+        res[i] = (a_i < borrow) ? BASE - 1 : a_i - borrow;
+        borrow = a_i < borrow;
+    }
+    return borrow;
+}
+
+/*
+ * res = a * b, res holds len_a + len_b limbs and must not overlap
+ * either operand. Picks the algorithm by operand size. Passing the same
+ * span as a and b squares it, which every tier does cheaper.
+ */
+void __mult_limbs(uint32_t* res, uint32_t* a, uint32_t len_a,
+                  uint32_t* b, uint32_t len_b)
+{
+    if (len_a < len_b) {
+        uint32_t* tmp = a; a = b; b = tmp;
+        uint32_t len_tmp = len_a; len_a = len_b; len_b = len_tmp;
+    }
+    /* below four digits the Karatsuba halves stop shrinking */
+    if (len_b < __karatsuba_threshold || len_b < 4) {
+        if (a == b && len_a == len_b)
+            __sqr_school(res, a, len_a);
+        else
+            __mult_school(res, a, len_a, b, len_b);
+    } else if (len_b >= __ntt_threshold
+               && len_b <= NTT_MAX_LEN / (2 * NTT_SPLIT)) {
+        if (len_a + len_b <= NTT_MAX_LEN / NTT_SPLIT)
+            __mult_ntt(res, a, len_a, b, len_b);
+        else
+            __mult_chunked(res, a, len_a, b, len_b);
+    } else if (len_b < __toom3_threshold || len_b < 12) {
+        if (len_a >= 2 * len_b)
+            __mult_chunked(res, a, len_a, b, len_b);
+        else
+            __mult_karatsuba(res, a, len_a, b, len_b);
+    } else if (2 * len_a >= 5 * len_b) {
+        __mult_chunked(res, a, len_a, b, len_b);
+    } else if (4 * len_a >= 7 * len_b) {
+        __mult_toom(res, a, len_a, b, len_b, 4, 2);
+    } else if (len_b < __toom4_threshold) {
+        if (4 * len_a < 5 * len_b)
+            __mult_toom(res, a, len_a, b, len_b, 3, 3);
+        else
+            __mult_toom(res, a, len_a, b, len_b, 3, 2);
+    } else {
+        if (6 * len_a < 7 * len_b)
+            __mult_toom(res, a, len_a, b, len_b, 4, 4);
+        else if (5 * len_a < 7 * len_b)
+            __mult_toom(res, a, len_a, b, len_b, 4, 3);
+        else
+            __mult_toom(res, a, len_a, b, len_b, 3, 2);
+    }
+}
+
+/*
+ * Column-wise (Comba) schoolbook product. Each column is summed in a
+ * 64 bit accumulator that only spills whole multiples of BASE into
+ * col_hi when it is about to overflow, so a column costs one reduction
+ * instead of one per partial product.
+ */
+void __mult_school(uint32_t* res, uint32_t* a, uint32_t len_a,
+                   uint32_t* b, uint32_t len_b)
+{
+    uint64_t acc = 0;
+    uint32_t len = len_a + len_b - 1;
+
+    for (uint32_t k = 0; k < len; k++) {
+        uint32_t i = (k < len_b) ? 0 : k - len_b + 1;
+        uint32_t end = (k < len_a) ? k : len_a - 1;
+        uint64_t col_hi = 0;
+        for (; i <= end; i++) {
+            uint64_t prod = (uint64_t) a[i] * b[k - i];
+            if (acc > UINT64_MAX - prod) {
+                col_hi += acc / BASE;
+                acc %= BASE;
+            }
+            acc += prod;
+        }
+        res[k] = acc % BASE;
+        acc = col_hi + acc / BASE;
+    }
+    res[len] = acc;
+}
+
+/*
+ * Schoolbook square, every cross product a[i] * a[j] with i < j is
+ * computed once and doubled, so about half the products of
+ * __mult_school are skipped.
+ */
+void __sqr_school(uint32_t* res, uint32_t* a, uint32_t len)
+{
+    uint64_t carry = 0;
+
+    for (uint32_t k = 0; k < 2 * len - 1; k++) {
+        uint32_t i = (k < len) ? 0 : k - len + 1;
+        uint64_t acc = 0;
+        uint64_t col_hi = 0;
+        for (; i < k - i; i++) {
+            uint64_t prod = (uint64_t) a[i] * a[k - i];
+            if (acc > UINT64_MAX - prod) {
+                col_hi += acc / BASE;
+                acc %= BASE;
+            }
+            acc += prod;
+        }
+        col_hi = 2 * (col_hi + acc / BASE);
+        acc = 2 * (acc % BASE);
+
+        /* diag + carry may itself overflow with binary limbs */
+        uint64_t diag = (k % 2) ? 0 : (uint64_t) a[k / 2] * a[k / 2];
+        col_hi += carry / BASE;
+        carry %= BASE;
+        if (acc > UINT64_MAX - diag - carry) {
+            col_hi += acc / BASE;
+            acc %= BASE;
+        }
+        acc += diag + carry;
+        res[k] = acc % BASE;
+        carry = col_hi + acc / BASE;
+    }
+    res[2 * len - 1] = carry;
+}
+
+/*
+ * Product of operands of very different lengths, len_a >= 2 * len_b.
+ *
+ * Cuts a into len_b sized pieces and accumulates the piecewise products,
+ * so every recursive call sees roughly balanced operands.
+ */
+void __mult_chunked(uint32_t* res, uint32_t* a, uint32_t len_a,
+                    uint32_t* b, uint32_t len_b)
+{
+    uint32_t len_res = len_a + len_b;
+    uint32_t* prod = __scratch(2 * len_b);
+    memset(res, 0, len_res * sizeof(*res));
+
+    for (uint32_t off = 0; off < len_a; off += len_b) {
+        uint32_t len = (len_a - off < len_b) ? len_a - off : len_b;
+        __mult_limbs(prod, a + off, len, b, len_b);
+        __add_limbs(res + off, res + off, len_res - off,
+                    prod, __trim_limbs(prod, len + len_b));
+    }
+    __scratch_free(prod);
+}
+
+/*
+ * Karatsuba product for 2 * len_b > len_a >= len_b >= 4.
+ *
+ * Splits both operands at h = len_a / 2 and recurses on three half size
+ * products.
+ */
+void __mult_karatsuba(uint32_t* res, uint32_t* a, uint32_t len_a,
+                      uint32_t* b, uint32_t len_b)
+{
+    uint32_t len_res = len_a + len_b;
+    uint32_t h = len_a / 2;
+    uint32_t len_a1 = len_a - h;
+    uint32_t len_b1 = len_b - h;
+    uint32_t len_sa = len_a1 + 1;
+    uint32_t len_sb = ((h > len_b1) ? h : len_b1) + 1;
+
+    uint32_t* sa = __scratch(len_sa + len_sb + len_sa + len_sb);
+    uint32_t* sb = sa + len_sa;
+    uint32_t* mid = sb + len_sb;
+
+    /* z0 = a0 * b0 and z2 = a1 * b1 land directly in their places */
+    __mult_limbs(res, a, h, b, h);
+    __mult_limbs(res + 2 * h, a + h, len_a1, b + h, len_b1);
+
+    /* z1 = (a0 + a1)(b0 + b1) - z0 - z2 */
+    sa[len_sa - 1] = __add_limbs(sa, a + h, len_a1, a, h);
+    if (a == b && len_a == len_b) {
+        sb = sa;
+        len_sb = len_sa;
+    } else if (len_b1 >= h) {
+        sb[len_sb - 1] = __add_limbs(sb, b + h, len_b1, b, h);
+    } else {
+        sb[len_sb - 1] = __add_limbs(sb, b, h, b + h, len_b1);
+    }
+
+    uint32_t len_mid = len_sa + len_sb;
+    __mult_limbs(mid, sa, len_sa, sb, len_sb);
+    __subtr_limbs(mid, mid, len_mid, res, 2 * h);
+    __subtr_limbs(mid, mid, len_mid, res + 2 * h, len_res - 2 * h);
+
+    __add_limbs(res + h, res + h, len_res - h,
+                mid, __trim_limbs(mid, len_mid));
+    __scratch_free(sa);
+}
+
+/*
+ * Toom-Cook product splitting a into k_a and b into k_b parts.
+ *
+ * Both operands are read as polynomials in BASE^len_part, evaluated at
+ * TOOM_POINTS and infinity, multiplied pointwise through __mult_limbs and
+ * interpolated back with TOOM_INTERP. Balanced splits (3, 3), (4, 4) and
+ * the unbalanced (3, 2), (4, 2), (4, 3) are used by __mult_limbs. The
+ * top part of either operand may be short or empty.
+ */
+void __mult_toom(uint32_t* res, uint32_t* a, uint32_t len_a,
+                 uint32_t* b, uint32_t len_b, uint32_t k_a, uint32_t k_b)
+{
+    uint32_t deg = k_a + k_b - 2;
+    uint32_t len_res = len_a + len_b;
+    uint32_t part_a = (len_a + k_a - 1) / k_a;
+    uint32_t part_b = (len_b + k_b - 1) / k_b;
+    uint32_t len_part = (part_a > part_b) ? part_a : part_b;
+    uint32_t len_ev = len_part + 1;
+    uint32_t len_w = 2 * len_ev;
+    uint32_t len_row = len_w + 1;
+
+    uint32_t* ev_a = __scratch(2 * deg * len_ev + (deg + 1) * len_w
+                               + deg * len_row);
+    uint32_t* ev_b = ev_a + deg * len_ev;
+    uint32_t* w = ev_b + deg * len_ev;
+    uint32_t* rows = w + (deg + 1) * len_w;
+    int sign_a[TOOM_MAX_DEG];
+    int sign_b[TOOM_MAX_DEG];
+
+    /* a square evaluates once and squares the values */
+    __toom_eval(ev_a, sign_a, a, len_a, len_part, k_a, deg);
+    if (a == b && len_a == len_b) {
+        ev_b = ev_a;
+        memcpy(sign_b, sign_a, sizeof(sign_a));
+    } else {
+        __toom_eval(ev_b, sign_b, b, len_b, len_part, k_b, deg);
+    }
+
+    /* pointwise products at the finite points */
+    for (uint32_t j = 0; j < deg; j++) {
+        uint32_t* w_j = w + j * len_w;
+        uint32_t len_ea = __trim_limbs(ev_a + j * len_ev, len_ev);
+        uint32_t len_eb = __trim_limbs(ev_b + j * len_ev, len_ev);
+        __mult_limbs(w_j, ev_a + j * len_ev, len_ea, ev_b + j * len_ev, len_eb);
+        memset(w_j + len_ea + len_eb, 0,
+               (len_w - len_ea - len_eb) * sizeof(*w_j));
+    }
+
+    /* and at infinity, the product of the top parts */
+    uint32_t* w_inf = w + deg * len_w;
+    uint32_t top_a = (k_a - 1) * len_part;
+    uint32_t top_b = (k_b - 1) * len_part;
+    uint32_t len_inf = 1;
+    memset(w_inf, 0, len_w * sizeof(*w_inf));
+    if (top_a < len_a && top_b < len_b) {
+        __mult_limbs(w_inf, a + top_a, len_a - top_a,
+                     b + top_b, len_b - top_b);
+        len_inf = __trim_limbs(w_inf, len_res - top_a - top_b);
+    }
+
+    /*
+     * Every coefficient row is a signed combination of the point values,
+     * all rows are built in one pass over the limbs with signed carries.
+     */
+    const int32_t* interp = TOOM_INTERP[deg];
+    int32_t coef[TOOM_MAX_DEG][TOOM_MAX_DEG + 1];
+    int64_t carry[TOOM_MAX_DEG] = {0};
+
+    for (uint32_t i = 0; i < deg; i++) {
+        for (uint32_t j = 0; j <= deg; j++) {
+            int sign = (j < deg) ? sign_a[j] * sign_b[j] : 1;
+            coef[i][j] = interp[i * (deg + 1) + j] * sign;
+        }
+    }
+    for (uint32_t t = 0; t < len_row; t++) {
+        for (uint32_t i = 0; i < deg; i++) {
+            int64_t cur = carry[i];
+            if (t < len_w) {
+                for (uint32_t j = 0; j <= deg; j++)
+                    cur += (int64_t) coef[i][j] * w[j * len_w + t];
+            }
+            int64_t q = cur / (int64_t) BASE;
+            int64_t r = cur - q * (int64_t) BASE;
+            if (r < 0) {
+                r += BASE;
+                --q;
+            }
+            rows[i * len_row + t] = r;
+            carry[i] = q;
+        }
+    }
+
+    /* the coefficients are sums of products, never negative */
+    memset(res, 0, len_res * sizeof(*res));
+    for (uint32_t i = 0; i < deg; i++) {
+        uint32_t* row = rows + i * len_row;
+        assert(carry[i] == 0);
+        __divexact_limbs(row, len_row, TOOM_DEN[deg]);
+        __add_limbs(res + i * len_part, res + i * len_part,
+                    len_res - i * len_part, row, __trim_limbs(row, len_row));
+    }
+    __add_limbs(res + deg * len_part, res + deg * len_part,
+                len_res - deg * len_part, w_inf, len_inf);
+    __scratch_free(ev_a);
+}
+
+/*
+ * Evaluates the k part polynomial a at the first n_points TOOM_POINTS.
+ *
+ * Value j goes to res + j * (len_part + 1) as a magnitude, its sign to
+ * signs[j]. All points are evaluated in one pass with Horner's rule per
+ * limb and signed carries.
+ */
+void __toom_eval(uint32_t* res, int* signs, uint32_t* a, uint32_t len_a,
+                 uint32_t len_part, uint32_t k, uint32_t n_points)
+{
+    uint32_t len_ev = len_part + 1;
+    int64_t carry[TOOM_MAX_DEG] = {0};
+
+    for (uint32_t t = 0; t < len_part; t++) {
+        for (uint32_t j = 0; j < n_points; j++) {
+            int64_t cur = 0;
+            for (uint32_t i = k; i > 0; i--) {
+                uint32_t off = (i - 1) * len_part + t;
+                cur = cur * TOOM_POINTS[j] + ((off < len_a) ? a[off] : 0);
+            }
+            cur += carry[j];
+
+            int64_t q = cur / (int64_t) BASE;
+            int64_t r = cur - q * (int64_t) BASE;
+            if (r < 0) {
+                r += BASE;
+                --q;
+            }
+            res[j * len_ev + t] = r;
+            carry[j] = q;
+        }
+    }
+
+    for (uint32_t j = 0; j < n_points; j++) {
+        uint32_t* ev = res + j * len_ev;
+        signs[j] = 1;
+        if (carry[j] < 0) {
+            /* value is carry * BASE^len_part + digits, negate it */
+            uint32_t borrow = 0;
+            for (uint32_t t = 0; t < len_part; t++) {
+                uint64_t d = (uint64_t) ev[t] + borrow;
+                ev[t] = (d == 0) ? 0 : BASE - d;
+                borrow = (d != 0);
+            }
+            carry[j] = -carry[j] - borrow;
+            signs[j] = -1;
+        }
+        ev[len_part] = carry[j];
+    }
+}
+
+/*
+ * Number theoretic transform product.
+ *
+ * Convolves the digits modulo each of NTT_MOD and recovers the exact
+ * convolution sums with the Chinese remainder theorem, so no rounding
+ * error can creep in. The sums are carried into BASE digits last.
+ * Requires len_b <= len_a, len_b <= NTT_MAX_LEN / (2 * NTT_SPLIT) and
+ * len_a + len_b <= NTT_MAX_LEN / NTT_SPLIT.
+ */
+void __mult_ntt(uint32_t* res, uint32_t* a, uint32_t len_a,
+                uint32_t* b, uint32_t len_b)
+{
+#ifdef BIGINT_BINARY_LIMBS
+    /* the halves are convolved in base 2^16 and packed back into res */
+    uint32_t* halves = __scratch(2 * (len_a + len_b));
+    uint32_t* out = halves;
+    int square = (a == b && len_a == len_b);
+    for (uint32_t i = 0; i < len_a; i++) {
+        halves[2 * i] = a[i] & 0xffff;
+        halves[2 * i + 1] = a[i] >> 16;
+    }
+    for (uint32_t i = 0; i < len_b; i++) {
+        halves[2 * (len_a + i)] = b[i] & 0xffff;
+        halves[2 * (len_a + i) + 1] = b[i] >> 16;
+    }
+    a = halves;
+    b = square ? halves : halves + 2 * len_a;
+    len_a *= 2;
+    len_b *= 2;
+    const uint32_t digit = 1 << 16;
+#else
+    uint32_t* out = res;
+    const uint32_t digit = BASE;
+#endif
+    uint32_t len_conv = len_a + len_b - 1;
+    uint32_t len = 1;
+    while (len < len_conv) len <<= 1;
+
+    uint32_t* conv = __scratch(NTT_PRIMES * len);
+    struct NttPrime np[NTT_PRIMES];
+
+    for (int i = 0; i < NTT_PRIMES; i++) {
+        __ntt_init_prime(&np[i], NTT_MOD[i]);
+        __ntt_convolve(&np[i], conv + i * len, a, len_a, b, len_b, len);
+    }
+
+    /* Garner's CRT, x = r0 + p0 * (t1 + p1 * t2) */
+    uint32_t p0 = np[0].p, p1 = np[1].p, p2 = np[2].p;
+    uint32_t inv_p0 = __ntt_pow(&np[1], p0 % p1, p1 - 2);
+    uint32_t inv_p01 = __ntt_pow(&np[2], (uint64_t) p0 * p1 % p2, p2 - 2);
+    uint128_t carry = 0;
+
+    for (uint32_t k = 0; k < len_conv; k++) {
+        uint32_t r0 = conv[k];
+        uint32_t r1 = conv[len + k];
+        uint32_t r2 = conv[2 * len + k];
+
+        uint64_t t1 = (r1 + p1 - r0 % p1) % p1 * (uint64_t) inv_p0 % p1;
+        uint64_t x01 = r0 + (uint64_t) p0 * t1;
+        uint64_t t2 = (r2 + p2 - x01 % p2) % p2 * (uint64_t) inv_p01 % p2;
+
+        carry += x01 + (uint128_t) p0 * p1 * t2;
+        out[k] = carry % digit;
+        carry /= digit;
+    }
+    out[len_conv] = carry;
+    __scratch_free(conv);
+
+#ifdef BIGINT_BINARY_LIMBS
+    for (uint32_t i = 0; i < (len_conv + 1) / 2; i++)
+        res[i] = out[2 * i] | out[2 * i + 1] << 16;
+    __scratch_free(halves);
+#endif
+}
+
+/*
+ * Fills in the Montgomery constants of a prime p < 2^30.
+ */
+void __ntt_init_prime(struct NttPrime* np, uint32_t p)
+{
+    uint32_t inv = p;  /* p * p == 1 mod 8, then Newton doubles the bits */
+    for (int i = 0; i < 4; i++) inv *= 2 - p * inv;
+    np->p = p;
+    np->p_inv = -inv;
+    np->r2 = (uint64_t) (((uint128_t) 1 << 64) % p);
+}
+
+/*
+ * Montgomery product a * b / 2^32 modulo p, for a, b < p.
+ */
+uint32_t __ntt_mul(struct NttPrime* np, uint32_t a, uint32_t b)
+{
+    uint64_t t = (uint64_t) a * b;
+    uint32_t m = (uint32_t) t * np->p_inv;
+    uint32_t u = (t + (uint64_t) m * np->p) >> 32;
+    return (u >= np->p) ? u - np->p : u;
+}
+
+/*
+ * a^e modulo p in plain (not Montgomery) form.
+ */
+uint32_t __ntt_pow(struct NttPrime* np, uint32_t a, uint64_t e)
+{
+    uint32_t res = __ntt_mul(np, 1, np->r2);
+    uint32_t base = __ntt_mul(np, a, np->r2);
+    while (e) {
+        if (e & 1) res = __ntt_mul(np, res, base);
+        base = __ntt_mul(np, base, base);
+        e >>= 1;
+    }
+    return __ntt_mul(np, res, 1);
 }
 
-int __gt(uint32_t* a, uint32_t* b) 
+/*
+ * Inplace iterative radix-2 transform of len (a power of two) values in
+ * Montgomery form. The inverse transform includes the 1 / len scaling.
+ */
+void __ntt(struct NttPrime* np, uint32_t* f, uint32_t len, int inverse)
 {
-    if (*(a) > *(b)) return 1;
-    if (*(a) == *(b)) {
-        int i = *(a);
-        while (i > 0) {
-            if (a[i] > b[i]) return 1;
-            if (a[i] < b[i]) return 0;
-            --i;
+    uint32_t p = np->p;
+
+    for (uint32_t i = 1, j = 0; i < len; i++) {
+        uint32_t bit = len >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            uint32_t tmp = f[i]; f[i] = f[j]; f[j] = tmp;
         }
     }
-    return 0;
+
+    uint32_t* roots = __scratch(len / 2 + 1);
+    uint32_t root = __ntt_pow(np, 3, (p - 1) / len);
+    if (inverse) root = __ntt_pow(np, root, p - 2);
+    roots[0] = __ntt_mul(np, 1, np->r2);
+    root = __ntt_mul(np, root, np->r2);
+    for (uint32_t i = 1; i < len / 2; i++)
+        roots[i] = __ntt_mul(np, roots[i - 1], root);
+
+    for (uint32_t half = 1; half < len; half <<= 1) {
+        uint32_t stride = len / (2 * half);
+        for (uint32_t i = 0; i < len; i += 2 * half) {
+            for (uint32_t j = 0; j < half; j++) {
+                uint32_t u = f[i + j];
+                uint32_t v = __ntt_mul(np, f[i + j + half], roots[j * stride]);
+                f[i + j] = (u + v >= p) ? u + v - p : u + v;
+                f[i + j + half] = (u >= v) ? u - v : u + p - v;
+            }
+        }
+    }
+    __scratch_free(roots);
+
+    if (inverse) {
+        uint32_t scale = __ntt_mul(np, __ntt_pow(np, len, p - 2), np->r2);
+        for (uint32_t i = 0; i < len; i++)
+            f[i] = __ntt_mul(np, f[i], scale);
+    }
 }
 
-int __eq(uint32_t* a, uint32_t* b) 
+/*
+ * Cyclic convolution of a and b modulo one prime into res (len values,
+ * plain form). len must cover len_a + len_b - 1.
+ */
+void __ntt_convolve(struct NttPrime* np, uint32_t* res, uint32_t* a,
+                    uint32_t len_a, uint32_t* b, uint32_t len_b,
+                    uint32_t len)
 {
-    if (*(a) != *(b)) return 0;
-    int i = *(a);
-    while (i > 0) {
-        if (a[i] != b[i]) return 0;
-        --i;
+    if (a == b && len_a == len_b) {
+        /* a square needs a single forward transform */
+        for (uint32_t i = 0; i < len; i++)
+            res[i] = (i < len_a) ? a[i] % np->p : 0;
+        __ntt(np, res, len, 0);
+        for (uint32_t i = 0; i < len; i++)
+            res[i] = __ntt_mul(np, res[i], res[i]);
+        __ntt(np, res, len, 1);
+        for (uint32_t i = 0; i < len; i++)
+            res[i] = __ntt_mul(np, res[i], np->r2);
+        return;
     }
-    return 1;
+
+    uint32_t* fb = __scratch(len);
+
+    /* the digits stay in plain form against Montgomery form twiddles,
+       only the pointwise product leaves a factor 2^-32 to undo */
+    for (uint32_t i = 0; i < len; i++) {
+        res[i] = (i < len_a) ? a[i] % np->p : 0;
+        fb[i] = (i < len_b) ? b[i] % np->p : 0;
+    }
+    __ntt(np, res, len, 0);
+    __ntt(np, fb, len, 0);
+    for (uint32_t i = 0; i < len; i++)
+        res[i] = __ntt_mul(np, res[i], fb[i]);
+    __ntt(np, res, len, 1);
+    for (uint32_t i = 0; i < len; i++)
+        res[i] = __ntt_mul(np, res[i], np->r2);
+
+    __scratch_free(fb);
 }
 
-int __st(uint32_t* a, uint32_t* b) 
+/*
+ * res += a * m for a small multiplier m, carrying through len_res >= len_a
+ * limbs of res. Returns the carry out of the top limb.
+ */
+uint32_t __addmul_limbs(uint32_t* res, uint32_t len_res,
+                        uint32_t* a, uint32_t len_a, uint32_t m)
 {
-    return ! __gt(a, b) && ! __eq(a, b);
+    uint64_t carry = 0;
+    uint32_t i = 0;
+
+    for (; i < len_a; i++) {
+        carry += res[i] + (uint64_t) a[i] * m;
+        res[i] = carry % BASE;
+        carry /= BASE;
+    }
+    for (; carry && i < len_res; i++) {
+        carry += res[i];
+        res[i] = carry % BASE;
+        carry /= BASE;
+    }
+    return carry;
 }
 
 /*
- * Inplace increment. Not thread safe.
+ * res -= a * m for a single limb m over len_a limbs of res. Returns what
+ * is still to be subtracted from res[len_a].
  */
-void __incr(uint32_t* n) 
+uint32_t __submul_limbs(uint32_t* res, uint32_t* a, uint32_t len_a,
+                        uint32_t m)
 {
-    for (int i = 1; i <= *n; i++) {
-        if (n[i] < BASE - 1) {
-            n[i] += 1;
-            return;
+    uint64_t carry = 0;
+
+    for (uint32_t i = 0; i < len_a; i++) {
+        carry += (uint64_t) a[i] * m;
+        uint32_t lo = carry % BASE;
+        carry /= BASE;
+        if (res[i] < lo) {
+            res[i] += BASE - lo;
+            carry++;
         } else {
-            n[i] = 0;
+            res[i] -= lo;
         }
     }
-
-    n = realloc(n, (*n + 2) * sizeof(*n));
-    ++*n;
-    n[*n] = 1;
+    return carry;
 }
 
 /*
- * Inplace decrement, halt at zero. Not thread safe.
+ * q = n / d for a single limb d, q holds len limbs and may alias n.
+ * Returns the remainder.
  */
-void __decr(uint32_t* n) 
+uint32_t __divmod_limb(uint32_t* q, uint32_t* n, uint32_t len, uint32_t d)
 {
-    if (__is_zero(n)) return;
+    uint64_t rem = 0;
 
-    for (int i = 1; i <= *n; i++) {
-        if (n[i] >= 1) {
-            n[i] -= 1;
-            if (i > 1 && i == *n && n[i] == 0) --*n;
-            return;
-        } else {
-            n[i] = BASE - 1;
-        }
+    for (uint32_t i = len; i > 0; i--) {
+        uint64_t cur = rem * BASE + n[i - 1];
+        q[i - 1] = cur / d;
+        rem = cur % d;
     }
+    return rem;
 }
 
-int __is_zero(uint32_t* n) 
+/*
+ * q = n / d and r = n % d, where len_n >= len_d and the top limb of d is
+ * nonzero. q receives len_n - len_d + 1 limbs and r receives len_d limbs,
+ * neither may overlap the operands.
+ *
+ * Both operands are scaled so that the top limb of d is at least BASE / 2,
+ * which keeps the quotient estimates of the kernels below within two of
+ * the true value. Large quotients are produced len_d limbs at a time by
+ * the recursive division.
+ */
+void __divmod_limbs(uint32_t* q, uint32_t* r, uint32_t* n, uint32_t len_n,
+                    uint32_t* d, uint32_t len_d)
 {
-    return *(n) == 1 && n[1] == 0 ? 1 : 0;
-}
+    if (len_d == 1) {
+        r[0] = __divmod_limb(q, n, len_n, d[0]);
+        return;
+    }
 
-int __is_one(uint32_t* n) 
-{
-    return *(n) == 1 && n[1] == 1 ? 1 : 0;
+    uint32_t scale = BASE / ((uint64_t) d[len_d - 1] + 1);
+    uint32_t* u = __scratch_zero(len_n + 1 + len_d);
+    uint32_t* v = u + len_n + 1;
+    __addmul_limbs(u, len_n + 1, n, len_n, scale);
+    __addmul_limbs(v, len_d, d, len_d, scale);
+
+    uint32_t len_q = len_n - len_d + 1;
+    if (len_d < __div_dc_threshold || len_q < __div_dc_threshold) {
+        __divmod_school(q, u, len_q, v, len_d);
+    } else {
+        /* the top block takes the odd limbs, the rest are len_d wide */
+        uint32_t len_block = (len_q % len_d) ? len_q % len_d : len_d;
+        for (uint32_t pos = len_q; pos > 0; len_block = len_d) {
+            pos -= len_block;
+            __divmod_dc(q + pos, u + pos, len_block, v, len_d);
+        }
+    }
+
+    __divmod_limb(r, u, len_d, scale);
+    __scratch_free(u);
 }
 
-uint32_t* __copy_digits(uint32_t* n) 
+/*
+ * Long division (Knuth, TAOCP vol. 2, 4.3.1, Algorithm D) of the
+ * len_d + len_q limbs of u by a scaled d of len_d >= 2 limbs, where the
+ * top len_d limbs of u are below d. q receives len_q limbs, the remainder
+ * is left in the low len_d limbs of u and the limbs above it are cleared.
+ *
+ * Each quotient limb is estimated from the top two limbs of the running
+ * remainder. The estimate is refined against the third limb and is then
+ * at most one too large, which the add back step corrects.
+ */
+void __divmod_school(uint32_t* q, uint32_t* u, uint32_t len_q,
+                     uint32_t* d, uint32_t len_d)
 {
-    int32_t len = *(n) + 1; 
-    uint32_t* cp_n = malloc(len * sizeof(*cp_n));
-    memcpy(cp_n, n, len * sizeof(*cp_n));
-    *(cp_n) = *(n);
-    return cp_n;
+    uint64_t d_top = d[len_d - 1];
+    uint64_t d_next = d[len_d - 2];
+
+    for (uint32_t j = len_q; j > 0; j--) {
+        uint32_t* u_j = u + j - 1;
+        uint64_t num = (uint64_t) u_j[len_d] * BASE + u_j[len_d - 1];
+        uint64_t q_hat = num / d_top;
+        uint64_t r_hat = num % d_top;
+
+        while (q_hat >= BASE
+               || q_hat * d_next > r_hat * BASE + u_j[len_d - 2]) {
+            q_hat--;
+            r_hat += d_top;
+            if (r_hat >= BASE) break;
+        }
+
+        int64_t top = (int64_t) u_j[len_d]
+            - __submul_limbs(u_j, d, len_d, q_hat);
+        if (top < 0) {
+            q_hat--;
+            top += __add_limbs(u_j, u_j, len_d, d, len_d);
+        }
+        u_j[len_d] = top;
+        q[j - 1] = q_hat;
+    }
 }
 
 /*
- * Returns the number of decimal digits.
+ * Recursive division (Burnikel and Ziegler, 1998), same contract as
+ * __divmod_school with len_q <= len_d.
+ *
+ * A square division of 2k limbs by k limbs is split into two divisions
+ * of 3/2 k limbs by k limbs. Those estimate their quotient from the top
+ * len_q limbs of d alone, which is a square division again, and then
+ * subtract the product of the estimate with the low limbs of d. As the
+ * top limb of d is normalised the estimate is at most two too large.
  */
-uint32_t __len_decimal(uint32_t* digits) 
+void __divmod_dc(uint32_t* q, uint32_t* u, uint32_t len_q,
+                 uint32_t* d, uint32_t len_d)
 {
-    int32_t len_msb = 0;
-    uint32_t msb = digits[*digits];    
+    /* single limb quotients cannot be split */
+    if (len_q < __div_dc_threshold || len_q < 2) {
+        __divmod_school(q, u, len_q, d, len_d);
+        return;
+    }
 
-    if (msb == 0) return 1;
+    if (len_q == len_d) {
+        uint32_t len_lo = len_q / 2;
+        __divmod_dc(q + len_lo, u + len_lo, len_q - len_lo, d, len_d);
+        __divmod_dc(q, u, len_lo, d, len_d);
+        return;
+    }
 
-    while (msb > 0) {
-        msb /= 10;
-        ++len_msb;
+    /* estimate from the top limbs, the window is u[len_lo, len_d + len_q) */
+    uint32_t len_lo = len_d - len_q;
+    uint32_t* d_hi = d + len_lo;
+    uint32_t* w = u + len_lo;
+    if (__cmp_limbs(w + len_q, d_hi, len_q) < 0) {
+        __divmod_dc(q, w, len_q, d_hi, len_q);
+    } else {
+        /* q = BASE^len_q - 1 leaves the remainder w_lo + d_hi */
+        for (uint32_t i = 0; i < len_q; i++) q[i] = BASE - 1;
+        memset(w + len_q, 0, len_q * sizeof(*w));
+        w[len_q] = __add_limbs(w, w, len_q, d_hi, len_q);
     }
-    
-    return len_msb + LEN_BASE * (*digits - 1);
+
+    uint32_t* prod = __scratch(len_d);
+    __mult_limbs(prod, q, len_q, d, len_lo);
+    int64_t top = (int64_t) u[len_d] - __subtr_limbs(u, u, len_d, prod, len_d);
+    while (top < 0) {
+        uint32_t one = 1;
+        __subtr_limbs(q, q, len_q, &one, 1);
+        top += __add_limbs(u, u, len_d, d, len_d);
+    }
+    u[len_d] = top;
+    __scratch_free(prod);
 }
 
 /*
- * Returns the argument with greater digits length
+ * Inplace division by a small d that is known to divide n exactly.
+ *
+ * Every partial dividend is below d * BASE < 2^48, so the quotient
+ * digit is a multiply by the 64 bit reciprocal of d rather than a
+ * hardware division.
  */
-uint32_t* __arg_len_max(uint32_t* a, uint32_t* b) 
+void __divexact_limbs(uint32_t* n, uint32_t len, uint32_t d)
 {
-    return *(a) > *(b) ? a : b;
+    uint64_t inv = UINT64_MAX / d + 1;
+    uint64_t rem = 0;
+
+    assert(d > 1 && d < (1 << 16));
+    for (uint32_t i = len; i > 0; i--) {
+        uint64_t cur = rem * BASE + n[i - 1];
+        uint64_t q = ((uint128_t) cur * inv) >> 64;
+        n[i - 1] = q;
+        rem = cur - q * d;
+    }
+    assert(rem == 0);
 }
 
 /*
- * Returns the argument with lesser digits length
+ * Compares two spans of equal length, returns -1, 0 or 1.
  */
-uint32_t* __arg_len_min(uint32_t* a, uint32_t* b) 
+int __cmp_limbs(uint32_t* a, uint32_t* b, uint32_t len)
 {
-    return *(a) < *(b) ? a : b;
+    for (uint32_t i = len; i > 0; i--) {
+        if (a[i - 1] != b[i - 1])
+            return (a[i - 1] > b[i - 1]) ? 1 : -1;
+    }
+    return 0;
 }
 
-uint32_t* __mult(uint32_t* a, uint32_t* b) 
+/*
+ * Returns the length of the span without its leading zero limbs,
+ * keeping at least one limb.
+ */
+uint32_t __trim_limbs(uint32_t* n, uint32_t len)
 {
-    if (__is_one(a)) return __copy_digits(b);
-    if (__is_one(b)) return __copy_digits(a);
-
-    int len = *(a) + *(b);
-    uint32_t* digits = calloc((len + 1), sizeof(*digits));
-
-    for (int i = 1; i <= *(a); i++) {
-        for (int j = 1; j <= *(b); j++) {
-            uint64_t tmp = (uint64_t) digits[i+j-1] + (uint64_t) a[i] * (uint64_t) b[j];
-            digits[i+j-1] = tmp % BASE;
-            digits[i+j] += tmp / BASE;
-        }
-    }
-
-    *digits = (digits[len] > 0) ? len : len - 1;
-    return digits;
+    while (len > 1 && n[len - 1] == 0) --len;
+    return len;
 }
 
 uint32_t* __add(uint32_t* a, uint32_t* b) 
@@ -706,7 +3257,7 @@ uint32_t* __add(uint32_t* a, uint32_t* b)
     uint32_t max_len = *(arg_max) + 1;
     uint32_t min_len = *(arg_min);
 
-    uint32_t* digits = malloc((max_len + 1) * sizeof(*digits));
+    uint32_t* digits = mem_malloc((max_len + 1) * sizeof(*digits));
     uint32_t carry = 0; 
 
     *digits = max_len;
@@ -714,14 +3265,14 @@ uint32_t* __add(uint32_t* a, uint32_t* b)
     for(int i = 1; i <= max_len; i++) {
         if (i > min_len && carry == 0) {
             memcpy(digits + i, arg_max + i, 
-               (max_len - i + 1) * sizeof(*digits));
+               (max_len - i) * sizeof(*digits));
             --*digits;
             break;
         }
 
         uint32_t a_i = i > *(a)? 0 : a[i];
         uint32_t b_i = i > *(b)? 0 : b[i];
-        uint32_t tmp = carry + a_i + b_i;
+        uint64_t tmp = (uint64_t) carry + a_i + b_i;
 
         if (tmp >= BASE) {
             digits[i] = tmp - BASE;
@@ -742,7 +3293,7 @@ uint32_t* __subtr(uint32_t* a, uint32_t* b)
     uint32_t max_len = *(a);
     uint32_t min_len = *(b);
 
-    uint32_t* digits = malloc((max_len + 1) * sizeof(*digits));
+    uint32_t* digits = mem_malloc((max_len + 1) * sizeof(*digits));
     uint32_t carry = 0;
 
     for(int i = 1; i <= max_len; i++) {
@@ -755,7 +3306,7 @@ uint32_t* __subtr(uint32_t* a, uint32_t* b)
         uint32_t a_i = i > *(a)? 0 : a[i];
         uint32_t b_i = i > *(b)? 0 : b[i];
 
-        if (a_i < b_i + carry) {
+        if (a_i < (uint64_t) b_i + carry) {
             digits[i] = BASE - carry - b_i + a_i;
             carry = 1;
         } else {
@@ -773,108 +3324,513 @@ uint32_t* __subtr(uint32_t* a, uint32_t* b)
 }
 
 /**
- * The quotian in each digit place will always be smaller than BASE.
+ * A single step of the long division, n < BASE * d so the quotian
+ * is a single digit.
  */
 struct QuoRem* __single_divmod(uint32_t* n, uint32_t* d) 
 {
-    struct QuoRem* quorem = malloc(sizeof(*quorem));
-    uint32_t* q_tmp = malloc(sizeof(*q_tmp));
-    uint32_t* prod = malloc(sizeof(*prod));
-    uint32_t steps = 1;
-    uint32_t qn;
-    uint32_t q;
-    
-    do {
-        free(q_tmp); free(prod); 
-        q_tmp = __assign_digits(steps);
-        prod = __mult(q_tmp, d);
-        qn = steps;
+    struct QuoRem* quorem = mem_malloc(sizeof(*quorem));
+    uint32_t** res = __divmod(n, d);
 
-        if (__eq(prod, n)) {
-            free(q_tmp); free(prod); 
-            quorem->quotian = qn;
-            quorem->remainder = __assign_digits(0);
-            return quorem;
-        }
-        steps *= 2;
-    } while (__st(prod, n));
-
-    q = qn / 2;
-    
-    // binary search
-    while(qn > q) {
-        free(q_tmp); free(prod);
-        q_tmp = __assign_digits((qn + q) / 2);
-        prod = __mult(q_tmp, d);
-        if (qn - q == 1) break;
-        if (__gt(prod, n)) {
-            qn = __to_decimal(q_tmp);
-        } else {
-            q = __to_decimal(q_tmp);
-        }
-    }
-    quorem->quotian = q;
-    quorem->remainder = __subtr(n, prod);
+    quorem->quotian = res[0][1];
+    quorem->remainder = res[1];
 
-    free(q_tmp); free(prod);
+    mem_free(res[0]); mem_free(res);
     return quorem;
 }
 
 uint32_t** __divmod(uint32_t* n, uint32_t* m) 
 {
-    uint32_t** res = malloc(sizeof(*res));
-    int len = *(n) - *(m) + 1;
-    uint32_t* carry;
-    uint32_t* quotian;
+    uint32_t** res = mem_malloc(2 * sizeof(*res));
 
     if (__st(n, m)) {
-        quotian = __assign_digits(0);
-        carry = __copy_digits(n);
-        res[0] = quotian;
-        res[1] = carry;
+        res[0] = __assign_digits(0);
+        res[1] = __copy_digits(n);
         return res;
     }
 
-    uint32_t* n_i = __slice_digits(n, len, *(n) + 1);
+    uint32_t len = *(n) - *(m) + 1;
+    uint32_t* quotian = mem_malloc((len + 1) * sizeof(*quotian));
+    uint32_t* remainder = mem_malloc((*(m) + 1) * sizeof(*remainder));
+
+    __divmod_limbs(quotian + 1, remainder + 1, n + 1, *(n), m + 1, *(m));
+    *quotian = __trim_limbs(quotian + 1, len);
+    *remainder = __trim_limbs(remainder + 1, *(m));
+
+    res[0] = quotian;
+    res[1] = remainder;
+    return res;
+}
+
+/*************************** MODULAR ARITHMETIC ***************************/
+
+/*
+ * Precomputes the modulus m. Barrett's mu is only computed when barrett
+ * is set or m has no Montgomery form, a one-off power_mod skips it.
+ */
+struct BigIntModCtx* __modctx_init(uint32_t* m, int barrett)
+{
+    struct BigIntModCtx* ctx = mem_malloc(sizeof(*ctx));
+    uint32_t len = *(m);
+    ctx->len = len;
+    ctx->sign = 1;
+    ctx->m = mem_malloc((3 * len + 2) * sizeof(*ctx->m));
+    ctx->one = ctx->m + len;
+    ctx->mu = ctx->one + len;
+    ctx->len_mu = 0;
+    memcpy(ctx->m, m + 1, len * sizeof(*ctx->m));
+
+    /* Montgomery needs m coprime to BASE, m_inv == 0 marks plain mode */
+    ctx->m_inv = (len <= MONT_MAX_LEN) ? __mont_inv(m[1]) : 0;
+
+    /* mu = BASE^(2 len) / m */
+    if (barrett || ! ctx->m_inv) {
+        uint32_t* u = __scratch_zero(3 * len + 1);
+        u[2 * len] = 1;
+        __divmod_limbs(ctx->mu, u + 2 * len + 1, u, 2 * len + 1, ctx->m, len);
+        ctx->len_mu = __trim_limbs(ctx->mu, len + 2);
+        __scratch_free(u);
+    }
+
+    __modctx_to(ctx, ctx->one, U_DIGIT_ONE);
+    return ctx;
+}
+
+void __modctx_free(struct BigIntModCtx** ctx)
+{
+    mem_free((*ctx)->m);
+    mem_free(*ctx);
+    *ctx = NULL;
+}
+
+/*
+ * Returns -m0^-1 modulo BASE by the extended Euclidean algorithm, or 0
+ * when m0 is not coprime to BASE.
+ */
+uint32_t __mont_inv(uint32_t m0)
+{
+    int64_t r_0 = BASE, r_1 = m0;
+    int64_t t_0 = 0, t_1 = 1;
+
+    while (r_1) {
+        int64_t q = r_0 / r_1;
+        int64_t tmp = r_0 - q * r_1; r_0 = r_1; r_1 = tmp;
+        tmp = t_0 - q * t_1; t_0 = t_1; t_1 = tmp;
+    }
+    if (r_0 != 1) return 0;
+    return (t_0 > 0) ? BASE - t_0 : -t_0;
+}
+
+/*
+ * Converts the digits n into a residue of len limbs at res.
+ */
+void __modctx_to(struct BigIntModCtx* ctx, uint32_t* res, uint32_t* n)
+{
+    if (! ctx->m_inv) {
+        __modctx_reduce(ctx, res, n + 1, *(n));
+        return;
+    }
+
+    /* n * BASE^len */
+    uint32_t* u = __scratch_zero(*(n) + ctx->len);
+    memcpy(u + ctx->len, n + 1, *(n) * sizeof(*u));
+    __modctx_reduce(ctx, res, u, *(n) + ctx->len);
+    __scratch_free(u);
+}
+
+/*
+ * res = n mod m for a span n of any length, res holds len limbs. The
+ * span is folded in from the top len limbs at a time, each step being a
+ * Barrett reduction of at most 2 * len limbs. A context without mu
+ * divides instead.
+ */
+void __modctx_reduce(struct BigIntModCtx* ctx, uint32_t* res, uint32_t* n,
+                     uint32_t len_n)
+{
+    uint32_t len = ctx->len;
+    if (! ctx->len_mu) {
+        memset(res, 0, len * sizeof(*res));
+        if (len_n < len) {
+            memcpy(res, n, len_n * sizeof(*res));
+            return;
+        }
+        uint32_t* q = __scratch(len_n - len + 1);
+        __divmod_limbs(q, res, n, len_n, ctx->m, len);
+        __scratch_free(q);
+        return;
+    }
+
+    uint32_t* x = __scratch(2 * len + MODCTX_SCRATCH(len));
+    uint32_t len_chunk = (len_n % len) ? len_n % len : len;
+
+    memset(res, 0, len * sizeof(*res));
+    for (uint32_t pos = len_n; pos > 0; len_chunk = len) {
+        pos -= len_chunk;
+        memset(x, 0, 2 * len * sizeof(*x));
+        memcpy(x, n + pos, len_chunk * sizeof(*x));
+        memcpy(x + len_chunk, res, len * sizeof(*x));
+        __barrett(ctx, res, x, x + 2 * len);
+    }
+    __scratch_free(x);
+}
+
+/*
+ * Barrett reduction (HAC 14.42) res = x mod m of a span x of 2 * len
+ * limbs. The quotient estimate is two multiplications by mu and m and is
+ * at most two too small. res holds len limbs and may alias x, tmp
+ * holds 5 * len + 6 limbs.
+ */
+void __barrett(struct BigIntModCtx* ctx, uint32_t* res, uint32_t* x,
+               uint32_t* tmp)
+{
+    uint32_t len = ctx->len;
+    uint32_t* q = tmp;
+    uint32_t* prod = q + 2 * len + 3;
+    uint32_t* r = prod + 2 * len + 2;
+
+    /* q = (x / BASE^(len - 1)) * mu / BASE^(len + 1) */
+    __mult_limbs(q, x + len - 1, len + 1, ctx->mu, ctx->len_mu);
+    __mult_limbs(prod, q + len + 1, ctx->len_mu, ctx->m, len);
+
+    /* the remainder fits len + 1 limbs, so the rest cancels */
+    __subtr_limbs(r, x, len + 1, prod, len + 1);
+    while (r[len] || __cmp_limbs(r, ctx->m, len) >= 0)
+        r[len] -= __subtr_limbs(r, r, len, ctx->m, len);
+    memcpy(res, r, len * sizeof(*res));
+}
 
-    if (! __st(n_i, m)) {
-        carry = __assign_digits(0);
+/*
+ * Returns the digits of the residue a.
+ */
+uint32_t* __modctx_from(struct BigIntModCtx* ctx, uint32_t* a)
+{
+    uint32_t len = ctx->len;
+    uint32_t* res = mem_malloc((len + 1) * sizeof(*res));
+
+    if (ctx->m_inv) {
+        /* a * 1 / R */
+        uint32_t* t = __scratch_zero(3 * len);
+        memcpy(t, a, len * sizeof(*t));
+        __mont_redc(res + 1, t, ctx->m, len, ctx->m_inv, t + 2 * len);
+        __scratch_free(t);
     } else {
-        --len;
-        carry = __right_shift(n_i);
-        free(n_i);
-        n_i = __slice_digits(n, len, len + 1);
-        
+        memcpy(res + 1, a, len * sizeof(*res));
     }
+    *res = __trim_limbs(res + 1, len);
+    return res;
+}
 
-    quotian = malloc((len + 1) * sizeof(*quotian));
-    *quotian = len;
-    
-    for (int pos = len; pos >= 1; pos--) {
-        uint32_t* sum = __add(n_i, carry);
-        struct QuoRem* quorem = __single_divmod(sum, m);
+/*
+ * res = a * b of two residues, res may alias either operand. tmp
+ * holds MODCTX_SCRATCH(len) limbs.
+ */
+void __modctx_mul(struct BigIntModCtx* ctx, uint32_t* res, uint32_t* a,
+                  uint32_t* b, uint32_t* tmp)
+{
+    uint32_t len = ctx->len;
+
+    if (ctx->m_inv) {
+        __mont_mul(res, a, b, ctx->m, len, ctx->m_inv, tmp);
+        return;
+    }
 
-        free(sum);
-        free(carry);
-        free(n_i);
+    __mult_limbs(tmp, a, len, b, len);
+    __barrett(ctx, res, tmp, tmp + 2 * len);
+}
 
-        quotian[pos] = quorem->quotian;
+/*
+ * Montgomery product res = a * b / BASE^len mod m of two reduced spans
+ * of len limbs. t holds 3 * len limbs, res may alias either operand.
+ */
+void __mont_mul(uint32_t* res, uint32_t* a, uint32_t* b, uint32_t* m,
+                uint32_t len, uint32_t m_inv, uint32_t* t)
+{
+    __mult_limbs(t, a, len, b, len);
+    __mont_redc(res, t, m, len, m_inv, t + 2 * len);
+}
 
-        if (pos > 1) {
-            carry = __right_shift(quorem->remainder);
-            n_i = __slice_digits(n, pos-1, pos);
+/*
+ * Montgomery reduction res = t / BASE^len mod m of a span t of 2 * len
+ * limbs below m * BASE^len, u holds len limbs.
+ *
+ * The quotient limbs u[k] = t * m_inv mod BASE and the columns of u * m
+ * are produced in one column-wise pass with the spilling accumulator of
+ * __mult_school, so a column costs one reduction by BASE rather than one
+ * per partial product.
+ */
+void __mont_redc(uint32_t* res, uint32_t* t, uint32_t* m, uint32_t len,
+                 uint32_t m_inv, uint32_t* u)
+{
+    uint64_t acc = 0;
+
+    for (uint32_t k = 0; k < 2 * len; k++) {
+        uint32_t i = (k < len) ? 0 : k - len + 1;
+        uint32_t end = (k < len) ? k : len;
+        uint64_t col_hi = 0;
+
+        acc += t[k];
+        for (; i < end; i++) {
+            uint64_t prod = (uint64_t) u[i] * m[k - i];
+            if (acc > UINT64_MAX - prod) {
+                col_hi += acc / BASE;
+                acc %= BASE;
+            }
+            acc += prod;
+        }
+        if (k < len) {
+            /* u[k] * m[0] clears the column */
+            u[k] = (acc % BASE) * m_inv % BASE;
+            uint64_t prod = (uint64_t) u[k] * m[0];
+            if (acc > UINT64_MAX - prod) {
+                col_hi += acc / BASE;
+                acc %= BASE;
+            }
+            acc += prod;
         } else {
-            carry = __copy_digits(quorem->remainder);
+            res[k - len] = acc % BASE;
         }
-        free(quorem->remainder);
-        free(quorem);
+        acc = col_hi + acc / BASE;
     }
 
-    res[0] = quotian;
-    res[1] = carry;
+    /* the result is below 2m */
+    if (acc || __cmp_limbs(res, m, len) >= 0)
+        __subtr_limbs(res, res, len, m, len);
+}
+
+/*
+ * Returns the exponent n in digits of EXP_BITS bits, little-endian and
+ * without a length prefix, and stores its bit length in n_bits.
+ */
+uint32_t* __to_base_bits(uint32_t* n, uint32_t* n_bits)
+{
+    uint32_t len = *(n);
+    /* a limb holds at most 32 bits */
+    uint32_t* rest = mem_malloc((len + len * 32 / EXP_BITS + 2) * sizeof(*rest));
+    uint32_t* res = rest + len;
+    uint32_t n_words = 0;
+
+    memcpy(rest, n + 1, len * sizeof(*rest));
+    do {
+        res[n_words++] = __divmod_limb(rest, rest, len, 1 << EXP_BITS);
+        len = __trim_limbs(rest, len);
+    } while (len > 1 || rest[0]);
+
+    uint32_t top = res[n_words - 1];
+    *n_bits = (n_words - 1) * EXP_BITS;
+    while (top) {
+        ++*n_bits;
+        top >>= 1;
+    }
+    memmove(rest, res, n_words * sizeof(*res));
+    return rest;
+}
+
+/*
+ * Left-to-right sliding window exponentiation. Runs of zero bits cost a
+ * squaring each, and every window of up to k bits ending in a one costs
+ * a single multiplication by a precomputed odd power of the base.
+ */
+uint32_t* __modctx_pow(struct BigIntModCtx* ctx, uint32_t* base, uint32_t* exp)
+{
+    if (__is_zero(exp))
+        return __modctx_from(ctx, ctx->one);
+
+    uint32_t len = ctx->len;
+    uint32_t n_bits;
+    uint32_t* bits = __to_base_bits(exp, &n_bits);
+#define EXP_BIT(i) ((bits[(i) / EXP_BITS] >> ((i) % EXP_BITS)) & 1)
+
+    uint32_t k = (n_bits > 671) ? 6 : (n_bits > 239) ? 5 :
+                 (n_bits > 79) ? 4 : (n_bits > 23) ? 3 : 2;
+    uint32_t n_odd = 1 << (k - 1);
+    uint32_t* tmp = __scratch(MODCTX_SCRATCH(len) + (n_odd + 2) * len);
+    uint32_t* odd = tmp + MODCTX_SCRATCH(len);
+    uint32_t* sqr = odd + n_odd * len;
+    uint32_t* acc = sqr + len;
+
+    /* odd[i] holds base^(2i + 1) */
+    __modctx_to(ctx, odd, base);
+    __modctx_mul(ctx, sqr, odd, odd, tmp);
+    for (uint32_t i = 1; i < n_odd; i++)
+        __modctx_mul(ctx, odd + i * len, odd + (i - 1) * len, sqr, tmp);
+
+    int started = 0;
+    for (int64_t i = (int64_t) n_bits - 1; i >= 0;) {
+        if (! EXP_BIT(i)) {
+            if (started) __modctx_mul(ctx, acc, acc, acc, tmp);
+            i--;
+            continue;
+        }
+        int64_t j = (i + 1 >= k) ? i + 1 - k : 0;
+        while (! EXP_BIT(j)) j++;
+
+        uint32_t window = 0;
+        for (int64_t l = i; l >= j; l--) {
+            window = 2 * window + EXP_BIT(l);
+            if (started) __modctx_mul(ctx, acc, acc, acc, tmp);
+        }
+        if (started)
+            __modctx_mul(ctx, acc, acc, odd + (window / 2) * len, tmp);
+        else
+            memcpy(acc, odd + (window / 2) * len, len * sizeof(*acc));
+        started = 1;
+        i = j - 1;
+    }
+#undef EXP_BIT
+
+    uint32_t* res = __modctx_from(ctx, acc);
+    __scratch_free(tmp); mem_free(bits);
     return res;
 }
 
+/****************************** RESULT CACHE ******************************/
+
+/** fills probe with the key of op on n_args operands, and its hash */
+void __cache_probe(struct CacheEntry* probe, int op, BigInt** args,
+                   uint32_t n_args)
+{
+    uint64_t h = __hash_mum(op ^ HASH_P0, HASH_P1);
+    probe->op = op;
+    probe->n_args = n_args;
+    for (uint32_t i = 0; i < n_args; i++) {
+        probe->args[i] = args[i];
+        h = __hash_mum(h ^ __hash_value(args[i]), HASH_P2);
+    }
+    probe->hash = h ^ (h >> 32);
+}
+
+/*
+ * Returns the entry of probe, now the most recently used, or NULL when
+ * the result is not remembered. Only cached operations count as misses.
+ */
+struct CacheEntry* __cache_find(BigIntCache* cache, struct CacheEntry* probe)
+{
+    if (! (cache->ops & BIGINT_CACHE_OP(probe->op))) return NULL;
+    struct CacheEntry* entry = hashmap_get_hashed(cache->map, probe,
+                                                  probe->hash);
+    if (! entry) {
+        ++cache->stats.misses;
+        return NULL;
+    }
+    ++cache->stats.hits;
+    __cache_unlink(cache, entry);
+    entry->next = cache->head;
+    if (cache->head) cache->head->prev = entry;
+    cache->head = entry;
+    if (! cache->tail) cache->tail = entry;
+    return entry;
+}
+
+/*
+ * Remembers res (or str) as the result of probe, evicting the least
+ * recently used entries to stay within the budget, which also holds the
+ * hash table. A result larger than the whole budget is not remembered.
+ */
+void __cache_put(BigIntCache* cache, struct CacheEntry* probe, BigInt* res,
+                 char* str)
+{
+    if (! (cache->ops & BIGINT_CACHE_OP(probe->op))) return;
+    struct CacheEntry* entry = mem_malloc(sizeof(*entry));
+    *entry = *probe;
+    entry->res = res ? bigint_copy(res) : NULL;
+    entry->str = NULL;
+    if (str) {
+        entry->str = mem_malloc(strlen(str) + 1);
+        strcpy(entry->str, str);
+    }
+    entry->bytes = sizeof(*entry)
+                 + (res ? __cache_bytes(entry->res) : strlen(str) + 1);
+    for (uint32_t i = 0; i < entry->n_args; i++) {
+        entry->args[i] = bigint_copy(probe->args[i]);
+        entry->bytes += __cache_bytes(entry->args[i]);
+    }
+
+    entry->prev = entry->next = NULL;
+    size_t table = hashmap_bytes(cache->map);
+    if (table + entry->bytes > cache->budget) {
+        __cache_drop(cache, entry);
+        return;
+    }
+    while (cache->stats.bytes + entry->bytes > cache->budget) {
+        __cache_drop(cache, cache->tail);
+        ++cache->stats.evictions;
+    }
+
+    entry->next = cache->head;
+    if (cache->head) cache->head->prev = entry;
+    cache->head = entry;
+    if (! cache->tail) cache->tail = entry;
+    hashmap_insert_hashed(cache->map, entry, entry, entry->hash);
+    ++cache->stats.entries;
+    cache->stats.bytes += entry->bytes + hashmap_bytes(cache->map) - table;
+
+    /* a grown table takes the room of the oldest entries */
+    while (cache->stats.bytes > cache->budget && cache->tail) {
+        __cache_drop(cache, cache->tail);
+        ++cache->stats.evictions;
+    }
+}
+
+/** takes entry off the recency list, if it is on it */
+void __cache_unlink(BigIntCache* cache, struct CacheEntry* entry)
+{
+    if (entry->prev) entry->prev->next = entry->next;
+    else if (cache->head == entry) cache->head = entry->next;
+    if (entry->next) entry->next->prev = entry->prev;
+    else if (cache->tail == entry) cache->tail = entry->prev;
+    entry->prev = entry->next = NULL;
+}
+
+/** forgets entry and frees it with its operands and result */
+void __cache_drop(BigIntCache* cache, struct CacheEntry* entry)
+{
+    if (hashmap_remove_hashed(cache->map, entry, entry->hash)) {
+        __cache_unlink(cache, entry);
+        --cache->stats.entries;
+        cache->stats.bytes -= entry->bytes;
+    }
+    for (uint32_t i = 0; i < entry->n_args; i++)
+        bigint_free(&entry->args[i]);
+    if (entry->res) bigint_free(&entry->res);
+    if (entry->str) mem_free(entry->str);
+    mem_free(entry);
+}
+
+/** the bytes of n, its handle and heap digits */
+size_t __cache_bytes(BigInt* n)
+{
+    size_t bytes = sizeof(*n);
+    if (! _is_inline(n)) bytes += (n->cap + 1) * sizeof(*(n->digits));
+    return bytes;
+}
+
+/** copies s like bigint_to_str allocates it, for the caller to free */
+char* __cache_str(char* s)
+{
+    size_t len = strlen(s);
+    char* copy = HOOK(malloc)((len + 1) * sizeof(*copy));
+    memcpy(copy, s, len + 1);
+    return copy;
+}
+
+/** the key comparison of the hashmap of a cache */
+int __cache_eq(void* a, void* b)
+{
+    struct CacheEntry* x = a;
+    struct CacheEntry* y = b;
+    if (x->op != y->op || x->n_args != y->n_args) return 0;
+    for (uint32_t i = 0; i < x->n_args; i++) {
+        if (! bigint_eq(x->args[i], y->args[i])) return 0;
+    }
+    return 1;
+}
+
+/** the hash of the hashmap of a cache, computed by __cache_probe */
+uint32_t __cache_hash(void* entry)
+{
+    return ((struct CacheEntry*) entry)->hash;
+}
+
 /***************************** TEST SUITE FUNCTIONS *****************************/
 
 void print_digits(char* var_name, uint32_t* digits) 
@@ -0,0 +1,152 @@
+/**
+ * @brief This file contains the implementation of a generic hashmap that
+ *        may be shared by threads.
+ *
+ * @author Vincent Mai
+ * @version 0.5.0
+ */
+
+#include "chashmap.h"
+#include "hashmap.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Shards picked when chashmap_init is given 0 */
+#define DEFAULT_SHARDS 64
+
+/* Bytes of a cache line, shards never share one */
+#define CACHE_LINE 64
+
+/**
+ * private struct
+ *
+ * A shard, aligned to a cache line so that threads locking neighbouring
+ * shards do not contend for the same line.
+ */
+struct Shard {
+    pthread_rwlock_t lock;
+    HashMap* map;
+} __attribute__((aligned(CACHE_LINE)));
+
+/** private struct */
+struct ConcurrentHashMap {
+    uint32_t n_shards;
+    uint32_t (*hash)(void*);
+    struct Shard* shards;
+};
+
+/** private functions */
+struct Shard* __shard(ConcurrentHashMap* cmap, uint32_t hash);
+
+ConcurrentHashMap* chashmap_init(uint32_t shards, uint32_t size,
+                                 int (*cmp_key)(void*, void*),
+                                 uint32_t (*hash)(void*),
+                                 char* (*repr_key)(void*),
+                                 char* (*repr_val)(void*)) {
+
+    uint32_t n_shards = 1;
+    if (! shards) shards = DEFAULT_SHARDS;
+    while (n_shards < shards) n_shards *= 2;
+
+    ConcurrentHashMap* cmap = malloc(sizeof(*cmap));
+    cmap->shards = aligned_alloc(CACHE_LINE, n_shards * sizeof(struct Shard));
+    if (! cmap->shards) {
+        fprintf(stderr, "Out of memory. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    cmap->n_shards = n_shards;
+    cmap->hash = hash;
+    for (uint32_t i = 0; i < n_shards; i++) {
+        pthread_rwlock_init(&cmap->shards[i].lock, NULL);
+        cmap->shards[i].map = hashmap_init(size / n_shards, cmp_key, hash,
+                                           repr_key, repr_val);
+    }
+    return cmap;
+}
+
+void chashmap_insert(ConcurrentHashMap* cmap, void* key, void* val) {
+    uint32_t hash = cmap->hash(key);
+    struct Shard* shard = __shard(cmap, hash);
+    pthread_rwlock_wrlock(&shard->lock);
+    hashmap_insert_hashed(shard->map, key, val, hash);
+    pthread_rwlock_unlock(&shard->lock);
+}
+
+void* chashmap_get_or_insert(ConcurrentHashMap* cmap, void* key, void* val) {
+    uint32_t hash = cmap->hash(key);
+    struct Shard* shard = __shard(cmap, hash);
+
+    /* most calls of a warm memo table find the key under the read lock */
+    pthread_rwlock_rdlock(&shard->lock);
+    void* found = hashmap_get_hashed(shard->map, key, hash);
+    pthread_rwlock_unlock(&shard->lock);
+    if (found) return found;
+
+    pthread_rwlock_wrlock(&shard->lock);
+    found = hashmap_get_hashed(shard->map, key, hash);
+    if (! found) {
+        hashmap_insert_hashed(shard->map, key, val, hash);
+        found = val;
+    }
+    pthread_rwlock_unlock(&shard->lock);
+    return found;
+}
+
+void* chashmap_get(ConcurrentHashMap* cmap, void* key) {
+    uint32_t hash = cmap->hash(key);
+    struct Shard* shard = __shard(cmap, hash);
+    pthread_rwlock_rdlock(&shard->lock);
+    void* val = hashmap_get_hashed(shard->map, key, hash);
+    pthread_rwlock_unlock(&shard->lock);
+    return val;
+}
+
+int chashmap_remove(ConcurrentHashMap* cmap, void* key) {
+    uint32_t hash = cmap->hash(key);
+    struct Shard* shard = __shard(cmap, hash);
+    pthread_rwlock_wrlock(&shard->lock);
+    int removed = hashmap_remove_hashed(shard->map, key, hash);
+    pthread_rwlock_unlock(&shard->lock);
+    return removed;
+}
+
+uint32_t chashmap_count(ConcurrentHashMap* cmap) {
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < cmap->n_shards; i++) {
+        pthread_rwlock_rdlock(&cmap->shards[i].lock);
+        count += cmap->shards[i].map->count;
+        pthread_rwlock_unlock(&cmap->shards[i].lock);
+    }
+    return count;
+}
+
+void chashmap_clear(ConcurrentHashMap* cmap) {
+    for (uint32_t i = 0; i < cmap->n_shards; i++) {
+        pthread_rwlock_wrlock(&cmap->shards[i].lock);
+        hashmap_clear(cmap->shards[i].map);
+        pthread_rwlock_unlock(&cmap->shards[i].lock);
+    }
+}
+
+void chashmap_free(ConcurrentHashMap** cmap) {
+    for (uint32_t i = 0; i < (*cmap)->n_shards; i++) {
+        pthread_rwlock_destroy(&(*cmap)->shards[i].lock);
+        hashmap_free(&(*cmap)->shards[i].map);
+    }
+    free((*cmap)->shards);
+    free(*cmap);
+    *cmap = NULL;
+}
+
+/***************************** PRIVATE FUNCTIONS ******************************/
+/**
+ * Returns the shard of a key hash. The hash is mixed to 64 bits and the
+ * shard scaled from the top 32, which the 32 bit slot mix of __hash in
+ * hashmap.c never sees, so keys of one shard still spread over its slots.
+ */
+struct Shard* __shard(ConcurrentHashMap* cmap, uint32_t hash) {
+    uint64_t mixed = (uint64_t) hash * 0xD6E8FEB86659FD93ull;
+    uint32_t top = mixed >> 32;
+    return &cmap->shards[((uint64_t) top * cmap->n_shards) >> 32];
+}
@@ -10,21 +10,31 @@
 #include <stdlib.h>
 #include <string.h>
 
-/** private struct */
-struct Node {
+/* Fewest slots of a hashmap */
+#define MIN_SIZE 8
+
+/**
+ * private struct
+ *
+ * An occupied slot stores its distance from the slot its hash points
+ * to plus one, an empty slot stores 0. The hash is kept so that probing
+ * and resizing need not call the user functions.
+ */
+struct HashEntry {
     void* key;
     void* val;
-    Node* next;
+    uint32_t hash;
+    uint32_t dist;
 };
 
 /** private functions */
 uint32_t __hash(HashMap* hmap, uint32_t pre_hash);
-Node* __node_find(HashMap* hmap, Node* node, void* key);
+uint32_t __max_load(uint32_t size);
 void __init_map(HashMap* hmap, uint32_t size);
-void __node_push(Node** node, void* key, void* val);
-void __node_del(HashMap* hmap, Node** node, void* key);
-void __node_free(Node** node);
-void __node_repr(HashMap* hmap, Node* node);
+void __resize(HashMap* hmap, uint32_t size);
+HashEntry* __entry_find(HashMap* hmap, void* key, uint32_t hash);
+void __entry_put(HashMap* hmap, void* key, void* val, uint32_t hash);
+void __entry_del(HashMap* hmap, HashEntry* entry);
 void __key_err(HashMap* hmap, void* key);
 
 HashMap* hashmap_init(uint32_t size,
@@ -33,157 +43,216 @@ HashMap* hashmap_init(uint32_t size,
                       char* (*repr_key)(void*),
                       char* (*repr_val)(void*)) {
 
-    HashMap* hmap = malloc(sizeof(*hmap));
-    __init_map(hmap, size);
-    hmap->size = size;
+    return hashmap_init_alloc(size, cmp_key, hash, repr_key, repr_val,
+                              malloc, free);
+}
+
+HashMap* hashmap_init_alloc(uint32_t size,
+                            int (*cmp_key)(void*, void*),
+                            uint32_t (*hash)(void*),
+                            char* (*repr_key)(void*),
+                            char* (*repr_val)(void*),
+                            void* (*malloc_fn)(size_t),
+                            void (*free_fn)(void*)) {
+
+    HashMap* hmap = malloc_fn(sizeof(*hmap));
+    if (! hmap) {
+        fprintf(stderr, "Out of memory. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
     hmap->cmp_key = cmp_key;
     hmap->hash = hash;
     hmap->repr_key = repr_key;
     hmap->repr_val = repr_val;
+    hmap->malloc_fn = malloc_fn;
+    hmap->free_fn = free_fn;
+    __init_map(hmap, MIN_SIZE);
+    hashmap_reserve(hmap, size);
     return hmap;
 }
 
 void hashmap_insert(HashMap* hmap, void* key, void* val) {
-    uint32_t map_idx = __hash(hmap, hmap->hash(key));
-    if (! hmap->map[map_idx]) {
-        Node* node = NULL;
-        __node_push(&node, key, val);
-        hmap->map[map_idx] = node; 
-    } else {
-        Node* found = __node_find(hmap, hmap->map[map_idx], key);
-        if (! found)
-            __node_push(&(hmap->map[map_idx]), key, val);
-        else 
-            found->val = val;
+    hashmap_insert_hashed(hmap, key, val, hmap->hash(key));
+}
+
+void hashmap_insert_hashed(HashMap* hmap, void* key, void* val,
+                           uint32_t hash) {
+    HashEntry* found = __entry_find(hmap, key, hash);
+    if (found) {
+        found->val = val;
+        return;
     }
+    if (hmap->count + 1 > __max_load(hmap->size))
+        __resize(hmap, hmap->size * 2);
+    __entry_put(hmap, key, val, hash);
+    ++hmap->count;
+}
+
+void hashmap_reserve(HashMap* hmap, uint32_t count) {
+    uint32_t size = hmap->size;
+    while (__max_load(size) < count && size < (1u << 31)) size *= 2;
+    if (size > hmap->size) __resize(hmap, size);
 }
 
 void* hashmap_get(HashMap* hmap, void* key) {
-    uint32_t map_idx = __hash(hmap, hmap->hash(key));
-    Node* res = __node_find(hmap, hmap->map[map_idx], key);
+    return hashmap_get_hashed(hmap, key, hmap->hash(key));
+}
+
+void* hashmap_get_hashed(HashMap* hmap, void* key, uint32_t hash) {
+    HashEntry* res = __entry_find(hmap, key, hash);
     return (res) ? res->val : NULL;
 }
 
 void hashmap_free(HashMap** hmap) {
-    for (int i = 0; i < (*hmap)->size; i++)
-        __node_free(&(*hmap)->map[i]);
-    free(*hmap);
+    void (*free_fn)(void*) = (*hmap)->free_fn;
+    free_fn((*hmap)->entries);
+    free_fn(*hmap);
     *hmap = NULL;
 }
 
-void hashmap_remove(HashMap* hmap, void* key) {    
-    uint32_t map_idx = __hash(hmap, hmap->hash(key));
-    __node_del(hmap, &(hmap->map[map_idx]), key);
+void hashmap_remove(HashMap* hmap, void* key) {
+    if (! hashmap_remove_hashed(hmap, key, hmap->hash(key)))
+        __key_err(hmap, key);
+}
+
+int hashmap_remove_hashed(HashMap* hmap, void* key, uint32_t hash) {
+    HashEntry* found = __entry_find(hmap, key, hash);
+    if (! found) return 0;
+    __entry_del(hmap, found);
+    return 1;
+}
+
+size_t hashmap_bytes(HashMap* hmap) {
+    return sizeof(*hmap) + hmap->size * sizeof(*(hmap->entries));
 }
 
 void hashmap_print(HashMap* hmap) {
-    for (int i = 0; i < hmap->size; i++) {
-        __node_repr(hmap, hmap->map[i]);
+    for (uint32_t i = 0; i < hmap->size; i++) {
+        HashEntry* entry = &hmap->entries[i];
+        if (! entry->dist) continue;
+        char* s_k = hmap->repr_key ? hmap->repr_key(entry->key) : NULL;
+        char* s_v = hmap->repr_val ? hmap->repr_val(entry->val) : NULL;
+        printf("(%s : %s)\n", s_k ? s_k : "?", s_v ? s_v : "?");
+        free(s_k); free(s_v);
     }
 }
 
 void hashmap_clear(HashMap* hmap) {
-    for (int i = 0; i < hmap->size; i++) {
-        __node_free(&(hmap->map[i]));
-    }
+    memset(hmap->entries, 0, hmap->size * sizeof(*(hmap->entries)));
+    hmap->count = 0;
 }
 
 /***************************** PRIVATE FUNCTIONS ******************************/
 /**
- * Initializes all map entries to NULL
+ * Initializes an empty map of size slots.
  */
 void __init_map(HashMap* hmap, uint32_t size) {
-    hmap->map = malloc(size * sizeof(*(hmap->map)));
-    for (int i = 0; i < size; i++) {
-        hmap->map[i] = NULL;
+    hmap->entries = hmap->malloc_fn(size * sizeof(*(hmap->entries)));
+    if (! hmap->entries) {
+        fprintf(stderr, "Out of memory. Exiting...\n");
+        exit(EXIT_FAILURE);
     }
+    memset(hmap->entries, 0, size * sizeof(*(hmap->entries)));
+    hmap->size = size;
+    hmap->count = 0;
 }
+
 /**
- * Returns a hash based on the pre_hash.
+ * Returns the slot of pre_hash. The user hash is mixed first, so hashes
+ * differing in their high bits only still spread over the slots.
  */
 uint32_t __hash(HashMap* hmap, uint32_t pre_hash) {
-    uint32_t map_idx = pre_hash % hmap->size;
-    return map_idx;
+    uint32_t mixed = pre_hash * 0x9E3779B9u;
+    mixed ^= mixed >> 16;
+    return mixed & (hmap->size - 1);
 }
 
 /**
- * Pushes a new node to the front of the linked list.
+ * Returns the number of entries size slots hold before growing.
  */
-void __node_push(Node** node, void* key, void* val) {
-    Node* new_node = malloc(sizeof(*new_node));
-    new_node->key = key;
-    new_node->val = val;
-    new_node->next = *node;
-    *node = new_node;
+uint32_t __max_load(uint32_t size) {
+    return size - size / 8;
 }
 
 /**
- * Given a key, returns a node if found in the linked list.
+ * Moves the entries to a map of size slots.
  */
-Node* __node_find(HashMap* hmap, Node* node, void* key) {
-    while (node) {
-        if (hmap->cmp_key(node->key, key))
-            return node;
-        node = node->next;
+void __resize(HashMap* hmap, uint32_t size) {
+    HashEntry* old = hmap->entries;
+    uint32_t old_size = hmap->size;
+    uint32_t count = hmap->count;
+
+    __init_map(hmap, size);
+    for (uint32_t i = 0; i < old_size; i++) {
+        if (old[i].dist)
+            __entry_put(hmap, old[i].key, old[i].val, old[i].hash);
     }
-    return NULL;
+    hmap->count = count;
+    hmap->free_fn(old);
 }
 
-/** 
- * Given a key, deletes the node that contains the key.
+/**
+ * Given a key, returns its entry if found in the map. Probing stops at
+ * the first entry closer to its own slot than the key would be.
  */
-void __node_del(HashMap* hmap, Node** node, void* key) {
-    Node* head = *node;
-    Node* pre_node = *node;
-    Node** cur_node = node;
-    while (*cur_node) {
-        if (hmap->cmp_key((*cur_node)->key, key)) {
-            if (pre_node == *cur_node) {
-                Node* removed = *cur_node;
-                *cur_node = (*cur_node)->next;
-                free(removed);
-            } else {
-                pre_node->next = (*cur_node)->next;
-                free(*cur_node);
-                *cur_node = NULL;
-                *node = head;
-            }
-            return;
-        }
-        pre_node = *cur_node;
-        *cur_node = (*cur_node)->next;
+HashEntry* __entry_find(HashMap* hmap, void* key, uint32_t hash) {
+    uint32_t mask = hmap->size - 1;
+    uint32_t i = __hash(hmap, hash);
+    for (uint32_t dist = 1; ; dist++, i = (i + 1) & mask) {
+        HashEntry* entry = &hmap->entries[i];
+        if (entry->dist < dist)
+            return NULL;
+        if (entry->hash == hash && hmap->cmp_key(entry->key, key))
+            return entry;
     }
-    __key_err(hmap, key);
 }
 
-/** 
- * Frees all node in a linked list
+/**
+ * Puts a key that is not in the map yet. Entries further from their slot
+ * take the place of closer ones, which carry on probing.
  */
-void __node_free(Node** node) {
-    if (*node) __node_free(&((*node)->next));
-    free(*node);
-    *node = NULL;
+void __entry_put(HashMap* hmap, void* key, void* val, uint32_t hash) {
+    uint32_t mask = hmap->size - 1;
+    uint32_t i = __hash(hmap, hash);
+    HashEntry cur = {key, val, hash, 1};
+    for (; ; cur.dist++, i = (i + 1) & mask) {
+        HashEntry* entry = &hmap->entries[i];
+        if (! entry->dist) {
+            *entry = cur;
+            return;
+        }
+        if (entry->dist < cur.dist) {
+            HashEntry tmp = *entry;
+            *entry = cur;
+            cur = tmp;
+        }
+    }
 }
 
-/** 
- * Returns a representation of the nodes in the linked list.
+/**
+ * Deletes an entry, shifting the entries after it back by one slot until
+ * one is in its own slot, so no tombstones are left behind.
  */
-void __node_repr(HashMap* hmap, Node* node) {
-    while (node) {
-        char* s_k = hmap->repr_key(node->key);
-        char* s_v = hmap->repr_val(node->val);
-        printf("(%s : %s)\n", s_k, s_v);
-        free(s_k); free(s_v);
-        node = node->next;
+void __entry_del(HashMap* hmap, HashEntry* entry) {
+    uint32_t mask = hmap->size - 1;
+    uint32_t i = entry - hmap->entries;
+    for (;;) {
+        HashEntry* next = &hmap->entries[(i + 1) & mask];
+        if (next->dist <= 1) break;
+        hmap->entries[i] = *next;
+        hmap->entries[i].dist--;
+        i = (i + 1) & mask;
     }
+    hmap->entries[i].dist = 0;
+    --hmap->count;
 }
 
 /**
  * Exits with error if key is not found.
  */
 void __key_err(HashMap* hmap, void* key) {
-    char* s_k = hmap->repr_key(key);
-    printf("Key '%s' not found.\n", s_k);
+    char* s_k = hmap->repr_key ? hmap->repr_key(key) : NULL;
+    printf("Key '%s' not found.\n", s_k ? s_k : "?");
     free(s_k);
     exit(1);
 }
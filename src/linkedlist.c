@@ -7,31 +7,32 @@
  */
 
 #include "linkedlist.h"
+#include "linkedlist_internal.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-/** Private Struct */
-struct Node {
-    void* data;
-    Node* next;
-};
-
 /** Private Functions */
 Node* _in_linkedlist(LinkedList* head, void* key); // deprecated
-void _free_node(Node* node);
+Node* _alloc_node(LinkedList* list);
+void _free_slabs(Slab* slab);
 
 LinkedList* linkedlist_init(int (*cmp_data)(void*, void*), 
                             char* (*repr_data)(void*)) {
-    LinkedList* list = malloc(sizeof(*list));
+    /* the node store follows the list in the same block */
+    LinkedList* list = malloc(sizeof(*list) + sizeof(*list->store));
     list->repr_data = repr_data;
     list->cmp_data = cmp_data;
     list->head = NULL;
+    list->store = (NodeStore*) (list + 1);
+    list->store->slabs = NULL;
+    list->store->spare = NULL;
+    list->store->used = 0;
     return list;
 }
 
 void linkedlist_push(LinkedList* list, void* data) {
-    Node* new_node = malloc(sizeof(*new_node));
+    Node* new_node = _alloc_node(list);
     new_node->data = data;
     new_node->next = list->head;
     list->head = new_node;
@@ -50,7 +51,7 @@ void* linkedlist_iter(LinkedList* list) {
 }
 
 void* linkedlist_next(Iterator** iter) {
-    if ((*iter)->data) {
+    if (*iter) {
         void* data = (*iter)->data;
         *iter = (*iter)->next;
         return data;
@@ -79,7 +80,8 @@ void* linkedlist_pop(LinkedList* list) {
     Node* removed = list->head;
     list->head = removed->next;
     void* data = removed->data;
-    free(removed);
+    removed->next = list->store->spare;
+    list->store->spare = removed;
     return data;
 }
 
@@ -93,8 +95,19 @@ int linkedlist_has(LinkedList* list, void* data) {
     return 0;
 }
 
+void linkedlist_clear(LinkedList* list) {
+    NodeStore* store = list->store;
+    list->head = NULL;
+    store->spare = NULL;
+    store->used = 0;
+    if (store->slabs) {
+        _free_slabs(store->slabs->next);
+        store->slabs->next = NULL;
+    }
+}
+
 void linkedlist_free(LinkedList** list) {
-    _free_node((*list)->head);
+    _free_slabs((*list)->store->slabs);
     free(*list);
     *list = NULL;
 }
@@ -117,11 +130,36 @@ Node* _in_linkedlist(LinkedList* list, void* data) {
 }
 
 /**
- * Frees all nodes from the linked list.
+ * Returns an unused node, a popped one if any, otherwise the next one of
+ * the newest slab. A new slab is allocated once that one is used up.
+ */
+Node* _alloc_node(LinkedList* list) {
+    NodeStore* store = list->store;
+    if (store->spare) {
+        Node* node = store->spare;
+        store->spare = node->next;
+        return node;
+    }
+    if (! store->slabs || store->used == SLAB_NODES) {
+        Slab* slab = malloc(sizeof(*slab));
+        if (! slab) {
+            fprintf(stderr, "Out of memory. Exiting...\n");
+            exit(EXIT_FAILURE);
+        }
+        slab->next = store->slabs;
+        store->slabs = slab;
+        store->used = 0;
+    }
+    return &store->slabs->nodes[store->used++];
+}
+
+/**
+ * Frees a chain of slabs, and all nodes with them.
  */
-void _free_node(Node* node) {
-    if (node->next) {
-        _free_node(node->next);
-        free(node);
+void _free_slabs(Slab* slab) {
+    while (slab) {
+        Slab* next = slab->next;
+        free(slab);
+        slab = next;
     }
 }
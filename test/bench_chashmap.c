@@ -0,0 +1,156 @@
+/**
+ * @file bench_chashmap.c
+ * @brief Contention benchmark of the concurrent hashmap.
+ *
+ * Threads look up and insert BigInt keys, 90% lookups and 10% inserts,
+ * on a HashMap behind one mutex, on a HashMap behind one read-write lock
+ * and on a ConcurrentHashMap. Prints the operations per second of each
+ * for each number of threads. Scaling only shows with as many cores.
+ *
+ * @author Vincent Mai
+ * @version 0.5.0
+ */
+
+#include "hashmap.h"
+#include "chashmap.h"
+#include "bigint/bigint.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifndef BENCH_OPS
+#define BENCH_OPS (1 << 20)
+#endif
+
+#ifndef BENCH_MAX_THREADS
+#define BENCH_MAX_THREADS 16
+#endif
+
+#ifndef BENCH_REPS
+#define BENCH_REPS 3
+#endif
+
+#define N_KEYS 4096
+
+BigInt* keys[N_KEYS];
+HashMap* hmap;
+pthread_mutex_t hmap_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_rwlock_t hmap_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+ConcurrentHashMap* cmap;
+
+int cmp_key(void* a, void* b)
+{
+    return bigint_eq(a, b);
+}
+
+char* repr_bigint(void* n)
+{
+    return bigint_to_str(n);
+}
+
+void* run_mutex(void* arg)
+{
+    unsigned seed = (unsigned) (uintptr_t) arg;
+    for (int r = 0; r < BENCH_OPS; r++) {
+        BigInt* key = keys[rand_r(&seed) % N_KEYS];
+        pthread_mutex_lock(&hmap_lock);
+        if (rand_r(&seed) % 10)
+            hashmap_get(hmap, key);
+        else
+            hashmap_insert(hmap, key, key);
+        pthread_mutex_unlock(&hmap_lock);
+    }
+    return NULL;
+}
+
+void* run_rwlock(void* arg)
+{
+    unsigned seed = (unsigned) (uintptr_t) arg;
+    for (int r = 0; r < BENCH_OPS; r++) {
+        BigInt* key = keys[rand_r(&seed) % N_KEYS];
+        if (rand_r(&seed) % 10) {
+            pthread_rwlock_rdlock(&hmap_rwlock);
+            hashmap_get(hmap, key);
+        } else {
+            pthread_rwlock_wrlock(&hmap_rwlock);
+            hashmap_insert(hmap, key, key);
+        }
+        pthread_rwlock_unlock(&hmap_rwlock);
+    }
+    return NULL;
+}
+
+void* run_sharded(void* arg)
+{
+    unsigned seed = (unsigned) (uintptr_t) arg;
+    for (int r = 0; r < BENCH_OPS; r++) {
+        BigInt* key = keys[rand_r(&seed) % N_KEYS];
+        if (rand_r(&seed) % 10)
+            chashmap_get(cmap, key);
+        else
+            chashmap_insert(cmap, key, key);
+    }
+    return NULL;
+}
+
+/* runs n_threads threads on fn, returning the operations per second */
+double run_once(void* (*fn)(void*), int n_threads)
+{
+    pthread_t threads[BENCH_MAX_THREADS];
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (intptr_t t = 0; t < n_threads; t++)
+        pthread_create(&threads[t], NULL, fn, (void*) (t + 1));
+    for (int t = 0; t < n_threads; t++)
+        pthread_join(threads[t], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double secs = (end.tv_sec - start.tv_sec)
+                + (end.tv_nsec - start.tv_nsec) / 1e9;
+    return (double) BENCH_OPS * n_threads / secs;
+}
+
+/* the best of BENCH_REPS runs, the others lost time to the machine */
+double run_threads(void* (*fn)(void*), int n_threads)
+{
+    double best = 0;
+    for (int r = 0; r < BENCH_REPS; r++) {
+        double ops = run_once(fn, n_threads);
+        if (ops > best) best = ops;
+    }
+    return best;
+}
+
+int main()
+{
+    char s[32];
+    for (int i = 0; i < N_KEYS; i++) {
+        sprintf(s, "%d999999999%d", i, i);
+        keys[i] = bigint_init(s);
+    }
+    hmap = hashmap_init(N_KEYS, cmp_key, bigint_hash,
+                        repr_bigint, repr_bigint);
+    cmap = chashmap_init(0, N_KEYS, cmp_key, bigint_hash,
+                         repr_bigint, repr_bigint);
+
+    printf("%8s %16s %16s %16s\n", "threads", "mutex ops/s",
+           "rwlock ops/s", "sharded ops/s");
+    for (int n = 1; n <= BENCH_MAX_THREADS; n *= 2) {
+        hashmap_clear(hmap);
+        double mutex = run_threads(run_mutex, n);
+        hashmap_clear(hmap);
+        double rwlock = run_threads(run_rwlock, n);
+        chashmap_clear(cmap);
+        double sharded = run_threads(run_sharded, n);
+        printf("%8d %16.0f %16.0f %16.0f\n", n, mutex, rwlock, sharded);
+    }
+
+    hashmap_free(&hmap);
+    chashmap_free(&cmap);
+    for (int i = 0; i < N_KEYS; i++)
+        bigint_free(&keys[i]);
+    return 0;
+}
@@ -30,6 +30,10 @@ BigInt* two_digit;
 BigInt* three_digit;
 BigInt* four_digit;
 
+/* the values above in order, for tests looping over all of them */
+#define N_FIXTURES 6
+BigInt* fixtures[N_FIXTURES];
+
 void set_up()
 {
     zero        = bigint_init(s_zero);
@@ -38,6 +42,9 @@ void set_up()
     two_digit   = bigint_init(s_two_digit);
     three_digit = bigint_init(s_three_digit);
     four_digit  = bigint_init(s_four_digit);
+
+    BigInt* ns[] = {zero, small, one_digit, two_digit, three_digit, four_digit};
+    memcpy(fixtures, ns, sizeof(ns));
 }
 
 void tear_down()
@@ -80,6 +87,17 @@ void test_bigint_init()
     BigInt* _three_digit = bigint_init(s_three_digit);
     BigInt* _four_digit = bigint_init(s_four_digit);
 
+#ifdef BIGINT_BINARY_LIMBS
+    /* binary limbs hold the converted digits */
+    uint32_t** u_giga[] = {&u_zero, &u_small, &u_one_digit,
+                           &u_two_digit, &u_three_digit, &u_four_digit};
+    for (int i = 0; i < 6; i++) {
+        uint32_t* limbs = __giga_to_limbs(*u_giga[i]);
+        __free_digits(*u_giga[i]);
+        *u_giga[i] = limbs;
+    }
+#endif
+
     assert_uint32_arr_eq(u_zero,        _zero->digits,        *u_zero + 1,        *(_zero->digits) + 1);
     assert_uint32_arr_eq(u_small,       _small->digits,       *u_small + 1,       *(_small->digits) + 1);
     assert_uint32_arr_eq(u_one_digit,   _one_digit->digits,   *u_one_digit + 1,   *(_one_digit->digits) + 1);
@@ -87,33 +105,26 @@ void test_bigint_init()
     assert_uint32_arr_eq(u_three_digit, _three_digit->digits, *u_three_digit + 1, *(_three_digit->digits) + 1);
     assert_uint32_arr_eq(u_four_digit,  _four_digit->digits,  *u_four_digit + 1,  *(_four_digit->digits) + 1);
 
-    assert_int_eq(strlen_s_zero,        _zero->sign_len);
-    assert_int_eq(strlen_s_small,       _small->sign_len);
-    assert_int_eq(strlen_s_one_digit,   _one_digit->sign_len);
-    assert_int_eq(strlen_s_two_digit,   _two_digit->sign_len);
-    assert_int_eq(strlen_s_three_digit, _three_digit->sign_len);
-    assert_int_eq(strlen_s_four_digit,  _four_digit->sign_len);
-
-    free(u_zero);
-    free(u_small);
-    free(u_one_digit);
-    free(u_two_digit);
-    free(u_three_digit);
-    free(u_four_digit);
-
-    free(_zero->digits);
-    free(_small->digits);
-    free(_one_digit->digits);
-    free(_two_digit->digits);
-    free(_three_digit->digits);
-    free(_four_digit->digits);
-
-    free(_zero);
-    free(_small);
-    free(_one_digit);
-    free(_two_digit);
-    free(_three_digit);
-    free(_four_digit);
+    assert_int_eq(strlen_s_zero,        _zero->sign * (int) bigint_num_digits(_zero));
+    assert_int_eq(strlen_s_small,       _small->sign * (int) bigint_num_digits(_small));
+    assert_int_eq(strlen_s_one_digit,   _one_digit->sign * (int) bigint_num_digits(_one_digit));
+    assert_int_eq(strlen_s_two_digit,   _two_digit->sign * (int) bigint_num_digits(_two_digit));
+    assert_int_eq(strlen_s_three_digit, _three_digit->sign * (int) bigint_num_digits(_three_digit));
+    assert_int_eq(strlen_s_four_digit,  _four_digit->sign * (int) bigint_num_digits(_four_digit));
+
+    __free_digits(u_zero);
+    __free_digits(u_small);
+    __free_digits(u_one_digit);
+    __free_digits(u_two_digit);
+    __free_digits(u_three_digit);
+    __free_digits(u_four_digit);
+
+    bigint_free(&_zero);
+    bigint_free(&_small);
+    bigint_free(&_one_digit);
+    bigint_free(&_two_digit);
+    bigint_free(&_three_digit);
+    bigint_free(&_four_digit);
 }
 
 void test_bigint_int_init()
@@ -128,17 +139,41 @@ void test_bigint_int_init()
     assert_uint32_arr_eq(small->digits,     _small->digits,     *(small->digits) + 1,     *(_small->digits) + 1);
     assert_uint32_arr_eq(one_digit->digits, _one_digit->digits, *(one_digit->digits) + 1, *(_one_digit->digits) + 1);
 
-    assert_int_eq(zero->sign_len,      _zero->sign_len);
-    assert_int_eq(small->sign_len,     _small->sign_len);
-    assert_int_eq(one_digit->sign_len, _one_digit->sign_len);
+    assert_int_eq(zero->sign,      _zero->sign);
+    assert_int_eq(small->sign,     _small->sign);
+    assert_int_eq(one_digit->sign, _one_digit->sign);
 
-    free(_zero->digits);
-    free(_small->digits);
-    free(_one_digit->digits);
+    bigint_free(&_zero);
+    bigint_free(&_small);
+    bigint_free(&_one_digit);
 
-    free(_zero);
-    free(_small);
-    free(_one_digit);
+    /* small values are writable, e.g. as the destination of a _to call */
+    char* expected[] = {"-5", "-1", "0", "7", "256"};
+    int32_t values[] = {-5, -1, 0, 7, 256};
+    for (int i = 0; i < 5; i++) {
+        BigInt* n = bigint_int_init(values[i]);
+        BigInt* m = bigint_int_init(values[i]);
+        assert_false(n == m);
+
+        char* s = bigint_to_str(n);
+        assert_str_eq(expected[i], s);
+        assert_int_eq((int) strlen(expected[i]) - (values[i] < 0),
+                      (int) bigint_num_digits(n));
+        free(s);
+
+        bigint_add_to(m, m, three_digit);
+        bigint_subtr_to(m, m, three_digit);
+        assert_true(bigint_eq(n, m));
+        bigint_free(&n);
+        bigint_free(&m);
+    }
+
+    BigInt* acc = bigint_int_init(0);
+    bigint_add_to(acc, one_digit, two_digit);
+    char* s_acc = bigint_to_str(acc);
+    assert_str_eq("-1", s_acc);
+    free(s_acc);
+    bigint_free(&acc);
 }
 
 void test_bigint_free()
@@ -186,6 +221,29 @@ void test_bigint_to_str()
     free(_s_three_digit);
 }
 
+void test_bigint_num_digits()
+{
+    for (int i = 0; i < N_FIXTURES; i++) {
+        for (int j = 0; j < N_FIXTURES; j++) {
+            /* results start without a cached length */
+            BigInt* prod = bigint_mult(fixtures[i], fixtures[j]);
+            BigInt* sum = bigint_add(fixtures[i], fixtures[j]);
+            uint32_t len_prod = bigint_num_digits(prod);
+            uint32_t len_sum = bigint_num_digits(sum);
+            char* s_prod = bigint_to_str(prod);
+            char* s_sum = bigint_to_str(sum);
+
+            assert_int_eq((int) (strlen(s_prod) - (s_prod[0] == '-')), len_prod);
+            assert_int_eq((int) (strlen(s_sum) - (s_sum[0] == '-')), len_sum);
+
+            free(s_prod);
+            free(s_sum);
+            bigint_free(&prod);
+            bigint_free(&sum);
+        }
+    }
+}
+
 void test_bigint_eq()
 {
     set_bail_on_fail();
@@ -387,6 +445,38 @@ void test_bigint_mult()
     bigint_free(&_neg_five_digit);
 }
 
+void test_bigint_sqr()
+{
+    BigInt* _zero           = bigint_sqr(zero);
+    BigInt* _pos_small      = bigint_sqr(small);
+    BigInt* _pos_three_digit = bigint_sqr(two_digit);
+    BigInt* _pos_five_digit = bigint_sqr(three_digit);
+
+    char s_pos_small[]      = "121";
+    char s_pos_three_digit[] = "1000000000000000000";
+    char s_pos_five_digit[] = "3999999996444444444790123456987654321";
+
+    char* _s_zero           = bigint_to_str(_zero);
+    char* _s_pos_small      = bigint_to_str(_pos_small);
+    char* _s_pos_three_digit = bigint_to_str(_pos_three_digit);
+    char* _s_pos_five_digit = bigint_to_str(_pos_five_digit);
+
+    assert_str_eq(s_zero,           _s_zero);
+    assert_str_eq(s_pos_small,      _s_pos_small);
+    assert_str_eq(s_pos_three_digit, _s_pos_three_digit);
+    assert_str_eq(s_pos_five_digit, _s_pos_five_digit);
+
+    free(_s_zero);
+    free(_s_pos_small);
+    free(_s_pos_three_digit);
+    free(_s_pos_five_digit);
+
+    bigint_free(&_zero);
+    bigint_free(&_pos_small);
+    bigint_free(&_pos_three_digit);
+    bigint_free(&_pos_five_digit);
+}
+
 void test_bigint_div()
 {
     // how to test for stderr return
@@ -396,6 +486,9 @@ void test_bigint_div()
     BigInt* _neg_one_digit   = bigint_div(one_digit, small);  
     BigInt* _denom_gt_nom    = bigint_div(one_digit, two_digit);  
     BigInt* _pos_three_digit = bigint_div(four_digit, two_digit);
+    BigInt* neg_one          = bigint_int_init(-1);
+    BigInt* _zero_by_neg     = bigint_div(zero, small);
+    BigInt* _by_neg_one      = bigint_div(three_digit, neg_one);
 
     char s_neg_one[]          = "-1";
     char s_neg_one_digit[]    = "-90909091";
@@ -405,21 +498,30 @@ void test_bigint_div()
     char* _s_neg_one_digit   = bigint_to_str(_neg_one_digit);
     char* _s_denom_gt_nom    = bigint_to_str(_denom_gt_nom);
     char* _s_pos_three_digit = bigint_to_str(_pos_three_digit);
+    char* _s_zero_by_neg     = bigint_to_str(_zero_by_neg);
+    char* _s_by_neg_one      = bigint_to_str(_by_neg_one);
 
     assert_str_eq(s_zero,            _s_zero);
     assert_str_eq(s_neg_one_digit,   _s_neg_one_digit);
     assert_str_eq(s_neg_one,         _s_denom_gt_nom);
     assert_str_eq(s_pos_three_digit, _s_pos_three_digit);
+    assert_str_eq(s_zero,            _s_zero_by_neg);
+    assert_str_eq("-1999999999111111111", _s_by_neg_one);
 
     free(_s_zero);
     free(_s_neg_one_digit);
     free(_s_denom_gt_nom);
     free(_s_pos_three_digit);
+    free(_s_zero_by_neg);
+    free(_s_by_neg_one);
 
     bigint_free(&_zero);
     bigint_free(&_neg_one_digit);
     bigint_free(&_denom_gt_nom);
     bigint_free(&_pos_three_digit);
+    bigint_free(&neg_one);
+    bigint_free(&_zero_by_neg);
+    bigint_free(&_by_neg_one);
 }
 
 void test_bigint_mod()
@@ -458,20 +560,589 @@ void test_bigint_power_mod()
 {
 }
 
+void test_bigint_to_ops()
+{
+    for (int i = 0; i < N_FIXTURES; i++) {
+        for (int j = 0; j < N_FIXTURES; j++) {
+            BigInt* a = fixtures[i];
+            BigInt* b = fixtures[j];
+            int n_ops = __is_zero(b->digits) ? 3 : 5;
+            BigInt* expected[] = {
+                bigint_add(a, b), bigint_subtr(a, b), bigint_mult(a, b),
+                (n_ops > 3) ? bigint_div(a, b) : NULL,
+                (n_ops > 3) ? bigint_mod(a, b) : NULL
+            };
+
+            /* dst aliasing the first operand, the second, and neither */
+            for (int alias = 0; alias < 3; alias++) {
+                for (int k = 0; k < n_ops; k++) {
+                    BigInt* a_k = (alias == 0) ? bigint_copy(a) : a;
+                    BigInt* b_k = (alias == 1) ? bigint_copy(b) : b;
+                    BigInt* dst = (alias == 0) ? a_k :
+                                  (alias == 1) ? b_k : bigint_copy(four_digit);
+
+                    if (k == 0) bigint_add_to(dst, a_k, b_k);
+                    if (k == 1) bigint_subtr_to(dst, a_k, b_k);
+                    if (k == 2) bigint_mult_to(dst, a_k, b_k);
+                    if (k == 3) bigint_div_to(dst, a_k, b_k);
+                    if (k == 4) bigint_mod_to(dst, a_k, b_k);
+
+                    assert_true(bigint_eq(expected[k], dst));
+                    bigint_free(&dst);
+                }
+            }
+            for (int k = 0; k < n_ops; k++) bigint_free(&expected[k]);
+        }
+    }
+}
+
+void test_bigint_reserve()
+{
+    BigInt* acc = bigint_copy(zero);
+    BigInt* expected = bigint_int_init(0);
+
+    bigint_reserve(acc, 64);
+    assert_true(acc->cap >= 64);
+
+    /* the reserved room absorbs every carry out of the top limb */
+    uint32_t* digits = acc->digits;
+    for (int i = 0; i < 200; i++) {
+        bigint_add_to(acc, acc, acc);
+        bigint_add_to(acc, acc, three_digit);
+    }
+    assert_true(digits == acc->digits);
+
+    for (int i = 0; i < 200; i++) {
+        BigInt* twice = bigint_add(expected, expected);
+        bigint_free(&expected);
+        expected = bigint_add(twice, three_digit);
+        bigint_free(&twice);
+    }
+    assert_true(bigint_eq(expected, acc));
+
+    bigint_shrink_to_fit(acc);
+    assert_int_eq((int) __pool_size(*(acc->digits) + 1), acc->cap + 1);
+    assert_true(bigint_eq(expected, acc));
+
+    bigint_free(&acc);
+    bigint_free(&expected);
+}
+
+void test_bigint_inline()
+{
+    char s_max[] = "999999999999999999";
+    char s_neg_max[] = "-999999999999999999";
+    char s_thousand[] = "1000";
+    char s_neg_thousand[] = "-1000";
+    BigInt* max = bigint_init(s_max);
+    BigInt* neg_max = bigint_init(s_neg_max);
+    BigInt* thousand = bigint_init(s_thousand);
+    BigInt* neg_thousand = bigint_init(s_neg_thousand);
+    BigInt* eleven = bigint_int_init(-11);
+
+    /* two limbs in either base, kept inside the struct */
+    assert_true(max->digits == max->small);
+    assert_true(eleven->digits == eleven->small);
+
+    BigInt* res = bigint_copy(max);
+    assert_true(res->digits == res->small);
+    char* expected[] = {
+        "1999999999999999998",
+        "999999999999999998000000000000000001",
+        "-1000000000000000010",
+        "-1000000000000000",
+        "1",
+        "-1000000000000000",
+        "-1"
+    };
+    for (int i = 0; i < 7; i++) {
+        switch (i) {
+            case 0: bigint_add_to(res, max, max); break;
+            case 1: bigint_mult_to(res, max, max); break;
+            case 2: bigint_subtr_to(res, eleven, max); break;
+            case 3: bigint_div_to(res, neg_max, thousand); break;
+            case 4: bigint_mod_to(res, neg_max, thousand); break;
+            case 5: bigint_div_to(res, max, neg_thousand); break;
+            case 6: bigint_mod_to(res, max, neg_thousand); break;
+        }
+        char* s = bigint_to_str(res);
+        assert_str_eq(expected[i], s);
+        free(s);
+    }
+
+    /* a value shrunk back to two limbs returns inline */
+    bigint_mult_to(res, max, max);
+    bigint_mod_to(res, res, thousand);
+    bigint_shrink_to_fit(res);
+    assert_true(res->digits == res->small);
+    assert_int_eq(1, *(res->digits));
+
+    bigint_free(&res);
+    bigint_free(&max);
+    bigint_free(&neg_max);
+    bigint_free(&thousand);
+    bigint_free(&neg_thousand);
+    bigint_free(&eleven);
+}
+
+int n_mallocs;
+int n_live;
+
+void* counting_malloc(size_t size)
+{
+    ++n_mallocs;
+    ++n_live;
+    return malloc(size);
+}
+
+void* counting_realloc(void* p, size_t size)
+{
+    ++n_mallocs;
+    if (! p) ++n_live;
+    return realloc(p, size);
+}
+
+void counting_free(void* p)
+{
+    if (p) --n_live;
+    free(p);
+}
+
+void test_bigint_allocator()
+{
+    bigint_set_allocator(counting_malloc, counting_realloc, counting_free);
+    n_mallocs = n_live = 0;
+
+    /* large enough for Karatsuba and the long division */
+    BigInt* x = bigint_sqr(four_digit);
+    for (int i = 0; i < 3; i++) bigint_mult_to(x, x, x);
+    BigInt* prod = bigint_mult(x, x);
+    BigInt* quo = bigint_div(x, four_digit);
+    assert_true(n_mallocs > 0);
+
+    /* warm destinations and arena, temporaries cost no allocation */
+    n_mallocs = 0;
+    bigint_mult_to(prod, x, x);
+    bigint_div_to(quo, x, four_digit);
+    bigint_mod_to(quo, x, four_digit);
+    assert_int_eq(0, n_mallocs);
+
+    bigint_free(&x);
+    bigint_free(&prod);
+    bigint_free(&quo);
+    bigint_scratch_release();
+    bigint_pool_trim();
+    assert_int_eq(0, n_live);
+
+    bigint_set_allocator(NULL, NULL, NULL);
+}
+
+void test_bigint_pool()
+{
+    size_t buffers;
+    bigint_pool_trim();
+    assert_int_eq(0, (int) bigint_pool_occupancy(&buffers));
+    assert_int_eq(0, (int) buffers);
+
+    /* a freed buffer serves the next result of its size class */
+    BigInt* prod = bigint_mult(four_digit, four_digit);
+    uint32_t* digits = prod->digits;
+    bigint_free(&prod);
+    assert_true(bigint_pool_occupancy(&buffers) >= 8 * sizeof(uint32_t));
+    assert_int_eq(1, (int) buffers);
+
+    prod = bigint_sqr(four_digit);
+    assert_true(digits == prod->digits);
+    assert_int_eq(0, (int) bigint_pool_occupancy(NULL));
+
+    bigint_free(&prod);
+    bigint_pool_trim();
+    assert_int_eq(0, (int) bigint_pool_occupancy(&buffers));
+    assert_int_eq(0, (int) buffers);
+}
+
+void test_bigint_modctx()
+{
+    BigInt* ms[] = {small, two_digit, three_digit};
+    int n_ms = sizeof(ms) / sizeof(ms[0]);
+
+    for (int i = 0; i < n_ms; i++) {
+        BigIntModCtx* ctx = bigint_modctx_init(ms[i]);
+
+        for (int j = 0; j < N_FIXTURES; j++) {
+            BigInt* rev = fixtures[N_FIXTURES - 1 - j];
+            BigInt* prod = bigint_mult(fixtures[j], rev);
+            BigInt* base = (j % 2) ? three_digit : one_digit;
+            BigInt* expected[] = {
+                bigint_mod(fixtures[j], ms[i]),
+                bigint_mod(prod, ms[i]),
+                bigint_power_mod(base, fixtures[j], ms[i])
+            };
+            BigInt* actual[] = {
+                bigint_mod_ctx(fixtures[j], ctx),
+                bigint_mulmod_ctx(fixtures[j], rev, ctx),
+                bigint_powmod_ctx(base, fixtures[j], ctx)
+            };
+
+            for (int k = 0; k < 3; k++) {
+                char* s_expected = bigint_to_str(expected[k]);
+                char* s_actual = bigint_to_str(actual[k]);
+                assert_str_eq(s_expected, s_actual);
+                free(s_expected); free(s_actual);
+                bigint_free(&expected[k]);
+                bigint_free(&actual[k]);
+            }
+            bigint_free(&prod);
+        }
+        bigint_modctx_free(&ctx);
+    }
+}
+
+void test_bigint_cache()
+{
+    BigIntCache* cache = bigint_cache_init(1 << 16,
+        BIGINT_CACHE_OP(BIGINT_OP_DIV) | BIGINT_CACHE_OP(BIGINT_OP_POWER_MOD)
+        | BIGINT_CACHE_OP(BIGINT_OP_TO_STR));
+
+    /* equal operands in other BigInts hit the remembered result */
+    BigInt* n = bigint_copy(four_digit);
+    BigInt* q1 = bigint_cache_div(cache, four_digit, three_digit);
+    BigInt* q2 = bigint_cache_div(cache, n, three_digit);
+    BigInt* q3 = bigint_div(four_digit, three_digit);
+    assert_true(bigint_eq(q1, q3) && bigint_eq(q2, q3));
+    BigInt* p1 = bigint_cache_power_mod(cache, three_digit, one_digit, small);
+    BigInt* p2 = bigint_cache_power_mod(cache, three_digit, one_digit, small);
+    assert_true(bigint_eq(p1, p2));
+    char* s1 = bigint_cache_to_str(cache, four_digit);
+    char* s2 = bigint_cache_to_str(cache, n);
+    assert_str_eq(s_four_digit, s1);
+    assert_str_eq(s_four_digit, s2);
+
+    /* operations left out are computed without the cache */
+    BigInt* r = bigint_cache_mod(cache, four_digit, three_digit);
+    bigint_free(&r);
+    BigIntCacheStats stats = bigint_cache_stats(cache);
+    assert_int_eq(3, (int) stats.hits);
+    assert_int_eq(3, (int) stats.misses);
+    assert_int_eq(3, (int) stats.entries);
+    assert_true(stats.bytes > 0 && stats.bytes <= 1 << 16);
+
+    /* a budget of the table and about one entry keeps the most recent
+       result */
+    BigIntCache* empty = bigint_cache_init(0, 0);
+    uint64_t table = bigint_cache_stats(empty).bytes;
+    BigIntCache* small_cache = bigint_cache_init(
+        table + (stats.bytes - table) / 2, BIGINT_CACHE_OP(BIGINT_OP_DIV));
+    BigInt* ds[] = {small, one_digit, three_digit, small};
+    for (int i = 0; i < 4; i++) {
+        BigInt* q = bigint_cache_div(small_cache, four_digit, ds[i]);
+        bigint_free(&q);
+    }
+    stats = bigint_cache_stats(small_cache);
+    assert_int_eq(0, (int) stats.hits);
+    assert_int_eq(4, (int) stats.misses);
+    assert_int_eq(3, (int) stats.evictions);
+    assert_int_eq(1, (int) stats.entries);
+
+    /* the budget holds as the table grows */
+    BigIntCache* grown = bigint_cache_init(1 << 12,
+                                           BIGINT_CACHE_OP(BIGINT_OP_DIV));
+    for (int i = 2; i < 200; i++) {
+        BigInt* d = bigint_int_init(i);
+        BigInt* q = bigint_cache_div(grown, small, d);
+        bigint_free(&q);
+        bigint_free(&d);
+        assert_true(bigint_cache_stats(grown).bytes <= 1 << 12);
+    }
+    assert_true(bigint_cache_stats(grown).entries > 8);
+    bigint_cache_free(&grown);
+
+    /* the table of a cleared cache is all that is left */
+    bigint_cache_clear(cache);
+    stats = bigint_cache_stats(cache);
+    assert_int_eq(0, (int) stats.entries);
+    assert_int_eq((int) table, (int) stats.bytes);
+    assert_int_eq(3, (int) stats.hits);
+
+    free(s1); free(s2);
+    bigint_free(&n);
+    bigint_free(&q1); bigint_free(&q2); bigint_free(&q3);
+    bigint_free(&p1); bigint_free(&p2);
+    bigint_cache_free(&cache);
+    bigint_cache_free(&small_cache);
+    bigint_cache_free(&empty);
+}
+
 void test_bigint_abs()
 {
+    char* expected[] = {"0", "11", "999999999", "1000000000",
+                        "1999999999111111111", "3222222222111111111000000000"};
+
+    for (int i = 0; i < N_FIXTURES; i++) {
+        int32_t sign = fixtures[i]->sign;
+        BigInt* res = bigint_abs(fixtures[i]);
+        char* s = bigint_to_str(res);
+        assert_str_eq(expected[i], s);
+        assert_int_eq(sign, fixtures[i]->sign);
+        free(s);
+        bigint_free(&res);
+    }
 }
 
 void test_bigint_neg()
 {
+    char* expected[] = {"0", "11", "-999999999", "1000000000",
+                        "-1999999999111111111", "3222222222111111111000000000"};
+
+    for (int i = 0; i < N_FIXTURES; i++) {
+        int32_t sign = fixtures[i]->sign;
+        BigInt* res = bigint_neg(fixtures[i]);
+        char* s = bigint_to_str(res);
+        assert_str_eq(expected[i], s);
+        assert_int_eq(sign, fixtures[i]->sign);
+
+        BigInt* back = bigint_neg(res);
+        assert_true(bigint_eq(fixtures[i], back));
+        free(s);
+        bigint_free(&res);
+        bigint_free(&back);
+    }
 }
 
 void test_bigint_copy()
 {
+    BigInt* cp = bigint_copy(four_digit);
+    assert_true(bigint_eq(four_digit, cp));
+    assert_true(cp->digits == four_digit->digits);
+
+    /* the first write clones the shared digits */
+    bigint_add_to(cp, cp, one_digit);
+    assert_false(cp->digits == four_digit->digits);
+    BigInt* sum = bigint_add(four_digit, one_digit);
+    assert_true(bigint_eq(sum, cp));
+    char* s = bigint_to_str(four_digit);
+    assert_str_eq(s_four_digit, s);
+    free(s);
+
+    /* freeing the original leaves the copy whole */
+    BigInt* orig = bigint_copy(sum);
+    BigInt* cp2 = bigint_copy(orig);
+    bigint_free(&orig);
+    assert_true(bigint_eq(sum, cp2));
+    bigint_mult_to(cp2, cp2, cp2);
+    bigint_free(&cp2);
+
+    bigint_free(&cp);
+    bigint_free(&sum);
+}
+
+void test_bigint_ref()
+{
+    BigInt* n = bigint_copy(three_digit);
+    BigInt* r = bigint_ref(n);
+    assert_true(n == r);
+
+    /* references share the value, writes included */
+    bigint_add_to(r, r, r);
+    BigInt* twice = bigint_add(three_digit, three_digit);
+    assert_true(bigint_eq(twice, n));
+
+    bigint_free(&n);
+    assert_true(n == NULL);
+    assert_true(bigint_eq(twice, r));
+    bigint_unref(&r);
+    assert_true(r == NULL);
+
+    BigInt* c = bigint_int_init(7);
+    BigInt* rc = bigint_ref(c);
+    assert_true(rc == c);
+    bigint_unref(&rc);
+    bigint_unref(&c);
+    bigint_free(&twice);
+}
+
+void test_bigint_fixed()
+{
+    BIGINT_FIXED(acc, 8);
+    BIGINT_FIXED(op, 4);
+    BIGINT_FIXED(rem, 4);
+    assert_true(bigint_eq(zero, acc));
+    bigint_add_to(op, three_digit, zero);
+    assert_true(bigint_eq(three_digit, op));
+
+    /* storage of no limbs has no room for the limb count */
+    uint64_t none[BIGINT_FIXED_WORDS(1)] = {0};
+    assert_true(bigint_fixed_init(none, 0) == NULL);
+    assert_true(none[BIGINT_FIXED_WORDS(1) - 1] == 0);
+
+    /* aliased and oversized results go through the arena, warm it first */
+    bigint_set_allocator(counting_malloc, counting_realloc, counting_free);
+    for (int i = 0; i < 2; i++) {
+        n_mallocs = 0;
+        bigint_mult_to(acc, op, four_digit);
+        bigint_mult_to(acc, acc, op);
+        bigint_div_to(acc, acc, four_digit);
+        bigint_subtr_to(acc, acc, op);
+        bigint_mod_to(rem, four_digit, op);
+    }
+    assert_int_eq(0, n_mallocs);
+    bigint_set_allocator(NULL, NULL, NULL);
+
+    /* the same results on the heap */
+    BigInt* sqr = bigint_sqr(three_digit);
+    BigInt* diff = bigint_subtr(sqr, three_digit);
+    BigInt* mod = bigint_mod(four_digit, three_digit);
+    assert_true(bigint_eq(diff, acc));
+    assert_true(bigint_eq(mod, rem));
+    assert_int_eq(bigint_hash(diff), bigint_hash(acc));
+
+    char* s_acc = bigint_to_str(acc);
+    char* s_diff = bigint_to_str(diff);
+    assert_str_eq(s_diff, s_acc);
+
+    /* copies leave the caller storage */
+    BigInt* cp = bigint_copy(acc);
+    bigint_add_to(acc, op, op);
+    assert_true(bigint_eq(diff, cp));
+
+    BigInt* fixed = acc;
+    bigint_free(&fixed);
+    assert_true(fixed == NULL);
+
+    struct { int tag; uint64_t storage[BIGINT_FIXED_WORDS(2)]; } s;
+    BigInt* member = bigint_fixed_init(s.storage, 2);
+    bigint_add_to(member, one_digit, two_digit);
+    BigInt* neg_one = bigint_int_init(-1);
+    assert_true(bigint_eq(neg_one, member));
+    bigint_free(&neg_one);
+
+    free(s_acc);
+    free(s_diff);
+    bigint_free(&sqr);
+    bigint_free(&diff);
+    bigint_free(&mod);
+    bigint_free(&cp);
+}
+
+void test_bigint_stats()
+{
+    bigint_stats_reset();
+    BigInt* x = bigint_mult(four_digit, four_digit);
+    bigint_add_to(x, x, one_digit);
+    BigIntStats stats = bigint_stats_snapshot();
+
+#ifdef BIGINT_STATS
+    /* calls nested in another one are not counted */
+    int len = *(four_digit->digits);
+    assert_int_eq(1, (int) stats.ops[BIGINT_OP_MULT].calls);
+    assert_int_eq(2 * len, (int) stats.ops[BIGINT_OP_MULT].limbs);
+    assert_int_eq(0, (int) stats.ops[BIGINT_OP_MULT_TO].calls);
+    assert_int_eq(1, (int) stats.ops[BIGINT_OP_ADD_TO].calls);
+    assert_true(stats.mallocs > 0);
+    assert_true(stats.bytes_peak >= stats.bytes_live);
+    assert_str_eq("mult_to", (char*) bigint_stats_name(BIGINT_OP_MULT_TO));
+
+    /* the handle goes back to the allocator, the digits to the pool */
+    uint64_t live = stats.bytes_live;
+    bigint_free(&x);
+    bigint_stats_reset();
+    stats = bigint_stats_snapshot();
+    assert_true(stats.bytes_live < live);
+    assert_true(stats.bytes_peak == stats.bytes_live);
+    assert_int_eq(0, (int) stats.ops[BIGINT_OP_MULT].calls);
+    assert_int_eq(0, (int) stats.ops[BIGINT_OP_FREE].calls);
+
+    /* growing a buffer is a realloc, allocations and frees balance */
+    bigint_scratch_release();
+    bigint_pool_trim();
+    bigint_stats_reset();
+    BigInt* y = bigint_init(s_four_digit);
+    bigint_reserve(y, 5000);
+    bigint_reserve(y, 10000);
+    assert_true(bigint_eq(y, four_digit));
+    bigint_free(&y);
+    bigint_scratch_release();
+    bigint_pool_trim();
+    stats = bigint_stats_snapshot();
+    assert_int_eq(1, (int) stats.reallocs);
+    assert_int_eq((int) stats.mallocs, (int) stats.frees);
+
+    /* cheap functions are counted but not timed */
+    assert_int_eq(1, (int) stats.ops[BIGINT_OP_EQ].calls);
+    assert_int_eq(0, (int) stats.ops[BIGINT_OP_EQ].nanos);
+
+    /*
+     * A filled cache gives every byte back, its table included. The
+     * dividend is freed too, copies leave their shared counter on it.
+     */
+    live = bigint_stats_snapshot().bytes_live;
+    BigInt* n = bigint_init(s_four_digit);
+    BigIntCache* cache = bigint_cache_init(1 << 16,
+        BIGINT_CACHE_OP(BIGINT_OP_DIV) | BIGINT_CACHE_OP(BIGINT_OP_TO_STR));
+    for (int i = 2; i < 100; i++) {
+        BigInt* d = bigint_int_init(i);
+        BigInt* q = bigint_cache_div(cache, n, d);
+        char* s = bigint_cache_to_str(cache, q);
+        free(s);
+        bigint_free(&q);
+        bigint_free(&d);
+    }
+    assert_true(bigint_cache_stats(cache).entries > 8);
+    assert_true(bigint_stats_snapshot().bytes_live > live);
+    bigint_cache_free(&cache);
+    bigint_free(&n);
+    bigint_scratch_release();
+    bigint_pool_trim();
+    stats = bigint_stats_snapshot();
+    assert_int_eq((int) live, (int) stats.bytes_live);
+    assert_int_eq((int) stats.mallocs, (int) stats.frees);
+#else
+    assert_int_eq(0, (int) stats.ops[BIGINT_OP_MULT].calls);
+    assert_int_eq(0, (int) stats.mallocs);
+    bigint_free(&x);
+#endif
 }
 
 void test_bigint_hash()
 {
+    /* equal values from every kind of storage */
+    BIGINT_FIXED(fixed, 8);
+    bigint_add_to(fixed, four_digit, zero);
+    BigInt* sum = bigint_add(four_digit, three_digit);
+    bigint_subtr_to(sum, sum, three_digit);
+    BigInt* padded = bigint_init("-0003222222222111111111000000000");
+    BigInt* same[] = {four_digit, fixed, sum, padded};
+    for (int i = 0; i < 4; i++) {
+        assert_true(bigint_hash64(four_digit) == bigint_hash64(same[i]));
+        assert_int_eq(bigint_hash(four_digit), bigint_hash(same[i]));
+    }
+
+    BigInt* neg_zero = bigint_init("-0");
+    BigInt* heap_seven = bigint_init("7");
+    assert_true(bigint_hash64(zero) == bigint_hash64(neg_zero));
+    BigInt* seven = bigint_int_init(7);
+    assert_true(bigint_hash64(seven) == bigint_hash64(heap_seven));
+    bigint_free(&seven);
+
+    /* neighbours and opposites spread over all 64 bits */
+    BigInt* ns[64];
+    uint64_t hashes[64];
+    uint64_t ones = 0;
+    for (int i = 0; i < 64; i++)
+        ns[i] = bigint_int_init((i % 2) ? 1000 + i / 2 : -1000 - i / 2);
+    bigint_hash_bulk(ns, 64, hashes);
+    for (int i = 0; i < 64; i++) {
+        assert_true(hashes[i] == bigint_hash64(ns[i]));
+        for (int j = 0; j < i; j++) assert_true(hashes[i] != hashes[j]);
+        ones |= hashes[i];
+    }
+    assert_true(ones == UINT64_MAX);
+
+    for (int i = 0; i < 64; i++) bigint_free(&ns[i]);
+    bigint_free(&sum);
+    bigint_free(&padded);
+    bigint_free(&neg_zero);
+    bigint_free(&heap_seven);
 }
 
 int main()
@@ -481,20 +1152,32 @@ int main()
         test_bigint_int_init,
         test_bigint_free,
         test_bigint_to_str,
+        test_bigint_num_digits,
         test_bigint_gt,
         test_bigint_st,
         test_bigint_eq,
         test_bigint_add,
         test_bigint_subtr,
         test_bigint_mult,
+        test_bigint_sqr,
         test_bigint_div,
-        test_bigint_mod
+        test_bigint_mod,
+        test_bigint_to_ops,
+        test_bigint_reserve,
+        test_bigint_inline,
+        test_bigint_allocator,
+        test_bigint_pool,
+        test_bigint_copy,
+        test_bigint_ref,
+        test_bigint_fixed,
+        test_bigint_stats,
+        test_bigint_modctx,
+        test_bigint_cache,
+        test_bigint_abs,
+        test_bigint_neg,
+        test_bigint_hash
         // test_bigint_log,
-        // test_bigint_power_mod,
-        // test_bigint_abs,
-        // test_bigint_neg,
-        // test_bigint_copy,
-        // test_bigint_hash
+        // test_bigint_power_mod
     );
     return 0;
 }
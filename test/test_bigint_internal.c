@@ -174,11 +174,11 @@ void test_incr()
     uint32_t incr_two_digit[]    = {2, 1, 1};
     uint32_t incr_four_digit[]   = {4, 1, 111111111, 222222222, 3};
     
-    // inplace increment
-    __incr(zero);
-    __incr(one_digit);
-    __incr(two_digit);
-    __incr(four_digit);
+    // inplace increment, the digits move when they grow
+    zero       = __incr(zero);
+    one_digit  = __incr(one_digit);
+    two_digit  = __incr(two_digit);
+    four_digit = __incr(four_digit);
 
     assert_uint32_arr_eq(incr_zero,         zero,           *incr_zero + 1,         *zero + 1);
     assert_uint32_arr_eq(incr_one_digit,    one_digit,      *incr_one_digit + 1,    *one_digit + 1);
@@ -385,6 +385,181 @@ void test_mult()
     free(_res_six_digit);
 }
 
+/* deterministic pseudo random digits for the larger operands */
+uint32_t* rand_digits(uint32_t len, uint32_t seed)
+{
+    uint32_t* digits = malloc((len + 1) * sizeof(*digits));
+    uint64_t state = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    *digits = len;
+    for (int i = 1; i <= len; i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        digits[i] = (state >> 33) % 1000000000;
+    }
+    if (digits[len] == 0) digits[len] = 1;
+    return digits;
+}
+
+void test_mult_karatsuba()
+{
+    uint32_t lens[][2] = {{4, 4}, {5, 4}, {7, 5}, {16, 16}, {33, 17}, {64, 9}, {100, 99}};
+    int n_lens = sizeof(lens) / sizeof(lens[0]);
+    uint32_t threshold = __karatsuba_threshold;
+
+    for (int i = 0; i < n_lens; i++) {
+        uint32_t* a = rand_digits(lens[i][0], 2 * i);
+        uint32_t* b = rand_digits(lens[i][1], 2 * i + 1);
+
+        __karatsuba_threshold = UINT32_MAX;
+        uint32_t* expected = __mult(a, b);
+        __karatsuba_threshold = 4;
+        uint32_t* actual = __mult(a, b);
+        uint32_t* swapped = __mult(b, a);
+
+        assert_uint32_arr_eq(expected, actual,  *expected + 1, *actual + 1);
+        assert_uint32_arr_eq(expected, swapped, *expected + 1, *swapped + 1);
+
+        free(a); free(b);
+        free(expected); free(actual); free(swapped);
+    }
+
+    /* all digits BASE - 1 exercise every carry path */
+    uint32_t* nines = rand_digits(40, 0);
+    for (int i = 1; i <= *nines; i++) nines[i] = 999999999;
+
+    __karatsuba_threshold = UINT32_MAX;
+    uint32_t* expected = __mult(nines, nines);
+    __karatsuba_threshold = 4;
+    uint32_t* actual = __mult(nines, nines);
+    assert_uint32_arr_eq(expected, actual, *expected + 1, *actual + 1);
+
+    __karatsuba_threshold = threshold;
+    free(nines); free(expected); free(actual);
+}
+
+void test_mult_toom()
+{
+    /* {len_a, len_b, k_a, k_b}, k_a = 0 goes through __mult dispatch */
+    uint32_t cases[][4] = {
+        {12, 12, 3, 3}, {31, 29, 3, 3}, {30, 20, 3, 2}, {41, 20, 4, 2},
+        {40, 40, 4, 4}, {53, 47, 4, 4}, {40, 30, 4, 3}, {13, 13, 4, 4},
+        {90, 85, 0, 0}, {150, 101, 0, 0}, {200, 60, 0, 0}, {333, 190, 0, 0}
+    };
+    int n_cases = sizeof(cases) / sizeof(cases[0]);
+    uint32_t kara = __karatsuba_threshold;
+    uint32_t toom3 = __toom3_threshold;
+    uint32_t toom4 = __toom4_threshold;
+
+    for (int i = 0; i < n_cases; i++) {
+        uint32_t* a = rand_digits(cases[i][0], 3 * i);
+        uint32_t* b = rand_digits(cases[i][1], 3 * i + 1);
+        if (i % 2)  /* all digits BASE - 1 */
+            for (int j = 1; j <= *a; j++) a[j] = 999999999;
+
+        __karatsuba_threshold = UINT32_MAX;
+        uint32_t* expected = __mult(a, b);
+
+        __karatsuba_threshold = 4;
+        __toom3_threshold = 12;
+        __toom4_threshold = 40;
+
+        uint32_t len = *a + *b;
+        uint32_t* actual = calloc(len + 1, sizeof(*actual));
+        if (cases[i][2]) {
+            __mult_toom(actual + 1, a + 1, *a, b + 1, *b,
+                        cases[i][2], cases[i][3]);
+        } else {
+            __mult_limbs(actual + 1, a + 1, *a, b + 1, *b);
+        }
+        *actual = __trim_limbs(actual + 1, len);
+
+        assert_uint32_arr_eq(expected, actual, *expected + 1, *actual + 1);
+
+        __karatsuba_threshold = kara;
+        __toom3_threshold = toom3;
+        __toom4_threshold = toom4;
+        free(a); free(b);
+        free(expected); free(actual);
+    }
+}
+
+void test_mult_ntt()
+{
+    uint32_t lens[][2] = {{1, 1}, {2, 1}, {5, 5}, {17, 16}, {64, 64}, {300, 7}, {513, 400}};
+    int n_lens = sizeof(lens) / sizeof(lens[0]);
+    uint32_t kara = __karatsuba_threshold;
+
+    for (int i = 0; i < n_lens; i++) {
+        uint32_t* a = rand_digits(lens[i][0], 5 * i);
+        uint32_t* b = rand_digits(lens[i][1], 5 * i + 1);
+        if (i % 2)  /* all digits BASE - 1 */
+            for (int j = 1; j <= *b; j++) b[j] = 999999999;
+
+        __karatsuba_threshold = UINT32_MAX;
+        uint32_t* expected = __mult(a, b);
+        __karatsuba_threshold = kara;
+
+        uint32_t len = *a + *b;
+        uint32_t* actual = calloc(len + 1, sizeof(*actual));
+        __mult_ntt(actual + 1, a + 1, *a, b + 1, *b);
+        *actual = __trim_limbs(actual + 1, len);
+
+        assert_uint32_arr_eq(expected, actual, *expected + 1, *actual + 1);
+
+        free(a); free(b);
+        free(expected); free(actual);
+    }
+}
+
+void test_sqr()
+{
+    uint32_t lens[] = {1, 2, 5, 16, 33, 120, 400};
+    int n_lens = sizeof(lens) / sizeof(lens[0]);
+    uint32_t kara = __karatsuba_threshold;
+    uint32_t toom3 = __toom3_threshold;
+    uint32_t toom4 = __toom4_threshold;
+    uint32_t ntt = __ntt_threshold;
+
+    for (int i = 0; i < n_lens; i++) {
+        uint32_t* a = rand_digits(lens[i], 7 * i);
+        if (i % 2)  /* all digits BASE - 1 */
+            for (int j = 1; j <= *a; j++) a[j] = 999999999;
+        uint32_t* b = __copy_digits(a);
+
+        /* distinct operands never take the squaring path */
+        __karatsuba_threshold = UINT32_MAX;
+        uint32_t* expected = __mult(a, b);
+
+        uint32_t len = 2 * *a;
+        uint32_t* actual = calloc(len + 1, sizeof(*actual));
+        uint32_t settings[][4] = {
+            {UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX},
+            {4, UINT32_MAX, UINT32_MAX, UINT32_MAX},
+            {4, 12, 40, UINT32_MAX},
+            {4, 12, 40, 64}
+        };
+        for (int k = 0; k < 4; k++) {
+            __karatsuba_threshold = settings[k][0];
+            __toom3_threshold = settings[k][1];
+            __toom4_threshold = settings[k][2];
+            __ntt_threshold = settings[k][3];
+            __mult_limbs(actual + 1, a + 1, *a, a + 1, *a);
+            *actual = __trim_limbs(actual + 1, len);
+            assert_uint32_arr_eq(expected, actual, *expected + 1, *actual + 1);
+        }
+
+        uint32_t* res = __mult(a, b);
+        assert_uint32_arr_eq(expected, res, *expected + 1, *res + 1);
+
+        __karatsuba_threshold = kara;
+        __toom3_threshold = toom3;
+        __toom4_threshold = toom4;
+        __ntt_threshold = ntt;
+
+        free(a); free(b);
+        free(expected); free(actual); free(res);
+    }
+}
+
 void test_single_divmod()
 {
     uint32_t two[]        = {1, 2};
@@ -456,34 +631,76 @@ void test_divmod()
     free(_res_g[0]); free(_res_g[1]); free(_res_g);
 }
 
-void test_power_mod()
+void test_divmod_knuth()
 {
-    int size = 92;    
-    // cache needs to be reset per __power_mod
-    HashMap* cache = hashmap_init(size, __cmp_key, __hash_digits,
-                                  __repr_keyval, __repr_keyval);
+    uint32_t lens[][2] = {{1, 1}, {5, 1}, {2, 2}, {7, 3}, {40, 17}, {90, 89}, {300, 120}};
+    int n_lens = sizeof(lens) / sizeof(lens[0]);
+
+    for (int i = 0; i < n_lens; i++) {
+        uint32_t* n = rand_digits(lens[i][0], 11 * i);
+        uint32_t* d = rand_digits(lens[i][1], 11 * i + 1);
+        if (i % 2) {  /* forces quotient corrections */
+            for (int j = 1; j <= *n; j++) n[j] = 999999999;
+            d[*d] = 1;
+        }
+
+        uint32_t** quorem = __divmod(n, d);
+        uint32_t* prod = __mult(quorem[0], d);
+        uint32_t* sum = __add(prod, quorem[1]);
+
+        assert_true(__st(quorem[1], d));
+        assert_uint32_arr_eq(n, sum, *n + 1, *sum + 1);
+
+        free(n); free(d); free(prod); free(sum);
+        free(quorem[0]); free(quorem[1]); free(quorem);
+    }
+}
 
+void test_divmod_dc()
+{
+    uint32_t lens[][2] = {{40, 20}, {41, 20}, {60, 13}, {100, 31}, {250, 100}, {1500, 700}};
+    int n_lens = sizeof(lens) / sizeof(lens[0]);
+    uint32_t dc = __div_dc_threshold;
+
+    for (int i = 0; i < n_lens; i++) {
+        uint32_t* n = rand_digits(lens[i][0], 13 * i);
+        uint32_t* d = rand_digits(lens[i][1], 13 * i + 1);
+        if (i % 2) {  /* forces quotient corrections */
+            for (int j = 1; j <= *n; j++) n[j] = 999999999;
+            for (int j = *d / 2; j <= *d; j++) d[j] = 999999999;
+            d[*d] = 1;
+        }
+
+        __div_dc_threshold = UINT32_MAX;
+        uint32_t** expected = __divmod(n, d);
+        __div_dc_threshold = 4;
+        uint32_t** actual = __divmod(n, d);
+        __div_dc_threshold = dc;
+
+        assert_uint32_arr_eq(expected[0], actual[0], *expected[0] + 1, *actual[0] + 1);
+        assert_uint32_arr_eq(expected[1], actual[1], *expected[1] + 1, *actual[1] + 1);
+
+        free(n); free(d);
+        free(expected[0]); free(expected[1]); free(expected);
+        free(actual[0]); free(actual[1]); free(actual);
+    }
+}
+
+void test_power_mod()
+{
     uint32_t res_c[] = {1, 333333334};
     uint32_t res_d[] = {3, 645076623, 339392621, 1};
     uint32_t res_e[] = {2, 173585468, 182018086};
 
-    uint32_t* _res_zero_a    = __power_mod(zero, three_digit, one, cache);
-    hashmap_clear(cache);
-    uint32_t* _res_zero_b    = __power_mod(two_digit, three_digit, two_digit, cache);
-    hashmap_clear(cache);
-    uint32_t* _res_one_a     = __power_mod(one, one_digit, two_digit, cache);
-    hashmap_clear(cache);
-    uint32_t* _res_one_b     = __power_mod(two_digit, zero, three_digit, cache);
-    hashmap_clear(cache);
-    uint32_t* _res_a         = __power_mod(one_digit, one, three_digit, cache);
-    hashmap_clear(cache);
-    uint32_t* _res_b         = __power_mod(two_digit, one_digit, one_digit, cache);
-    hashmap_clear(cache);
-    uint32_t* _res_c         = __power_mod(three_digit, four_digit, one_digit, cache);
-    hashmap_clear(cache);
-    uint32_t* _res_d         = __power_mod(two_digit, two_digit, three_digit, cache); // BUG Found!
-    hashmap_clear(cache);
-    uint32_t* _res_e         = __power_mod(two_digit, four_digit, three_digit, cache); // BUG Found!
+    uint32_t* _res_zero_a    = __power_mod(zero, three_digit, one);
+    uint32_t* _res_zero_b    = __power_mod(two_digit, three_digit, two_digit);
+    uint32_t* _res_one_a     = __power_mod(one, one_digit, two_digit);
+    uint32_t* _res_one_b     = __power_mod(two_digit, zero, three_digit);
+    uint32_t* _res_a         = __power_mod(one_digit, one, three_digit);
+    uint32_t* _res_b         = __power_mod(two_digit, one_digit, one_digit);
+    uint32_t* _res_c         = __power_mod(three_digit, four_digit, one_digit);
+    uint32_t* _res_d         = __power_mod(two_digit, two_digit, three_digit); // BUG Found!
+    uint32_t* _res_e         = __power_mod(two_digit, four_digit, three_digit); // BUG Found!
     
     assert_uint32_arr_eq(zero,          _res_zero_a,    *zero + 1,         *_res_zero_a + 1);
     assert_uint32_arr_eq(zero,          _res_zero_b,    *zero + 1,         *_res_zero_b + 1);
@@ -495,8 +712,6 @@ void test_power_mod()
     assert_uint32_arr_eq(res_d,         _res_d,         *res_d + 1,        *_res_d + 1);
     assert_uint32_arr_eq(res_e,         _res_e,         *res_e + 1,        *_res_e + 1);
 
-    hashmap_free(&cache);
-    
     free(_res_zero_a);
     free(_res_zero_b);
     free(_res_one_a);
@@ -508,6 +723,76 @@ void test_power_mod()
     free(_res_e);
 }
 
+void test_power_mod_mont()
+{
+    uint32_t lens[] = {1, 2, 3, 9, 30};
+    uint32_t exps[] = {1, 2, 7, 64, 1000};
+    int n_lens = sizeof(lens) / sizeof(lens[0]);
+
+    for (int i = 0; i < n_lens; i++) {
+        uint32_t* base = rand_digits(2 * lens[i], 17 * i);
+        uint32_t* exp = __assign_digits(exps[i]);
+        uint32_t* m_odd = rand_digits(lens[i], 17 * i + 1);
+        uint32_t* m_even = __copy_digits(m_odd);
+        m_odd[1] |= 1;
+        m_odd[1] += (m_odd[1] % 5) ? 0 : 2;
+        m_even[1] = (m_even[1] < 10) ? 10 : m_even[1] - m_even[1] % 10;
+        assert_true(__mont_inv(m_odd[1]) != 0);
+        assert_true(__mont_inv(m_even[1]) == 0);
+
+        uint32_t* ms[] = {m_odd, m_even};
+        for (int j = 0; j < 2; j++) {
+            /* reference by repeated multiplication */
+            uint32_t** quorem = __divmod(one, ms[j]);
+            uint32_t* expected = quorem[1];
+            free(quorem[0]); free(quorem);
+            for (uint32_t e = 0; e < exps[i]; e++) {
+                uint32_t* prod = __mult(expected, base);
+                quorem = __divmod(prod, ms[j]);
+                free(expected); free(prod); free(quorem[0]);
+                expected = quorem[1];
+                free(quorem);
+            }
+
+            uint32_t* actual = __power_mod(base, exp, ms[j]);
+            assert_uint32_arr_eq(expected, actual, *expected + 1, *actual + 1);
+            free(expected); free(actual);
+        }
+        free(base); free(exp); free(m_odd); free(m_even);
+    }
+}
+
+void test_modctx_reduce()
+{
+    uint32_t lens[][2] = {{1, 1}, {3, 1}, {2, 2}, {5, 3}, {80, 40}, {453, 150}};
+    int n_lens = sizeof(lens) / sizeof(lens[0]);
+
+    for (int i = 0; i < n_lens; i++) {
+        uint32_t* n = rand_digits(lens[i][0], 19 * i);
+        uint32_t* m = rand_digits(lens[i][1], 19 * i + 1);
+        if (i % 2) {  /* m = BASE^(len - 1) has the longest mu */
+            memset(m + 1, 0, *m * sizeof(*m));
+            m[*m] = 1;
+            for (int j = 1; j <= *n; j++) n[j] = 999999999;
+        }
+
+        uint32_t** quorem = __divmod(n, m);
+        uint32_t* rem = calloc(*m + 1, sizeof(*rem));
+
+        /* by Barrett, and by division when mu is skipped */
+        for (int barrett = 0; barrett < 2; barrett++) {
+            struct BigIntModCtx* ctx = __modctx_init(m, barrett);
+            __modctx_reduce(ctx, rem + 1, n + 1, *n);
+            *rem = __trim_limbs(rem + 1, *m);
+            assert_uint32_arr_eq(quorem[1], rem, *quorem[1] + 1, *rem + 1);
+            __modctx_free(&ctx);
+        }
+
+        free(n); free(m); free(rem);
+        free(quorem[0]); free(quorem[1]); free(quorem);
+    }
+}
+
 // expose __same_sign as public API?
 void test_same_sign()
 {
@@ -524,14 +809,10 @@ void test_same_sign()
     assert_false(__same_sign(pos_one, neg_one));
     assert_false(__same_sign(neg_zero, neg_one));
 
-    free(pos_zero->digits);
-    free(neg_zero->digits);
-    free(pos_one->digits);
-    free(neg_one->digits);
-    free(pos_zero);
-    free(neg_zero);
-    free(pos_one);
-    free(neg_one);
+    bigint_free(&pos_zero);
+    bigint_free(&neg_zero);
+    bigint_free(&pos_one);
+    bigint_free(&neg_one);
 }
 
 int main()
@@ -556,9 +837,17 @@ int main()
         test_add,
         test_subtr,
         test_mult,
+        test_mult_karatsuba,
+        test_mult_toom,
+        test_mult_ntt,
+        test_sqr,
         test_single_divmod,
         test_divmod,
+        test_divmod_knuth,
+        test_divmod_dc,
         test_power_mod,
+        test_power_mod_mont,
+        test_modctx_reduce,
         test_same_sign
     );
     return 0;
@@ -0,0 +1,311 @@
+/**
+ * @file test_bigint_stress.c
+ * @brief Concurrency stress testing for the BigInt C library.
+ *
+ * Many threads read the same BigInts at once, each checking its results
+ * against the single threaded ones and the operands against their values.
+ * Build with -fsanitize=thread to have data races reported as well.
+ *
+ * @author Vincent Mai
+ * @version 0.5.0
+ */
+
+#include "bigint/bigint.h"
+#include "sunittest/sunittest.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifndef STRESS_THREADS
+#define STRESS_THREADS 16
+#endif
+
+#ifndef STRESS_ROUNDS
+#define STRESS_ROUNDS 200
+#endif
+
+#define N_OPERANDS 5
+#define N_OPS 8
+
+/* read-only global variables */
+
+char* s_operands[N_OPERANDS] = {
+    "-11",
+    "1999999999111111111",
+    "-3222222222111111111000000000",
+    "123456789012345678901234567890123456789012345678901234567890"
+    "123456789012345678901234567890123456789012345678901234567890",
+    "-98765432109876543210987654321098765432109876543210987654321"
+    "98765432109876543210987654321098765432109876543210987654321"
+    "98765432109876543210987654321098765432109876543210987654321",
+};
+
+BigInt* operands[N_OPERANDS];
+BigIntModCtx* ctx;
+
+/* results of each op on each pair of operands, computed by one thread */
+char* expected[N_OPERANDS][N_OPERANDS][N_OPS];
+uint32_t hashes[N_OPERANDS];
+
+void set_up()
+{
+    for (int i = 0; i < N_OPERANDS; i++)
+        operands[i] = bigint_init(s_operands[i]);
+    ctx = bigint_modctx_init(operands[3]);
+}
+
+void tear_down()
+{
+    for (int i = 0; i < N_OPERANDS; i++)
+        bigint_free(&operands[i]);
+    bigint_modctx_free(&ctx);
+}
+
+/** the op-th operation on a and b, as a new BigInt */
+BigInt* compute(int op, BigInt* a, BigInt* b)
+{
+    if (op == 5) {
+        BigInt* base = bigint_abs(a);
+        BigInt* exp = bigint_abs(b);
+        BigInt* res = bigint_power_mod(base, exp, operands[3]);
+        bigint_free(&base);
+        bigint_free(&exp);
+        return res;
+    }
+
+    switch (op) {
+    case 0: return bigint_add(a, b);
+    case 1: return bigint_subtr(a, b);
+    case 2: return bigint_mult(a, b);
+    case 3: return bigint_div(a, b);
+    case 4: return bigint_mod(a, b);
+    case 6: return bigint_mulmod_ctx(a, b, ctx);
+    default: return bigint_neg(a);
+    }
+}
+
+/** the same through a destination variant writing to dst */
+void compute_to(int op, BigInt* dst, BigInt* a, BigInt* b)
+{
+    switch (op) {
+    case 0: bigint_add_to(dst, a, b); break;
+    case 1: bigint_subtr_to(dst, a, b); break;
+    case 2: bigint_mult_to(dst, a, b); break;
+    case 3: bigint_div_to(dst, a, b); break;
+    case 4: bigint_mod_to(dst, a, b); break;
+    default: {
+        BigInt* res = compute(op, a, b);
+        BigInt* zero = bigint_int_init(0);
+        bigint_add_to(dst, res, zero);
+        bigint_free(&res);
+        bigint_free(&zero);
+    }
+    }
+}
+
+void compute_expected()
+{
+    for (int i = 0; i < N_OPERANDS; i++) {
+        hashes[i] = bigint_hash(operands[i]);
+        for (int j = 0; j < N_OPERANDS; j++) {
+            for (int op = 0; op < N_OPS; op++) {
+                BigInt* res = compute(op, operands[i], operands[j]);
+                expected[i][j][op] = bigint_to_str(res);
+                bigint_free(&res);
+            }
+        }
+    }
+}
+
+void free_expected()
+{
+    for (int i = 0; i < N_OPERANDS; i++)
+        for (int j = 0; j < N_OPERANDS; j++)
+            for (int op = 0; op < N_OPS; op++)
+                free(expected[i][j][op]);
+}
+
+/** counts the results of a thread that differ from the expected ones */
+int check(BigInt* res, int i, int j, int op)
+{
+    char* s = bigint_to_str(res);
+    int bad = strcmp(s, expected[i][j][op]) != 0;
+    free(s);
+    return bad;
+}
+
+void* read_shared(void* arg)
+{
+    int* errors = arg;
+    unsigned seed = (unsigned) (uintptr_t) arg;
+    BigInt* dst = bigint_init("0");
+
+    for (int r = 0; r < STRESS_ROUNDS; r++) {
+        int i = rand_r(&seed) % N_OPERANDS;
+        int j = rand_r(&seed) % N_OPERANDS;
+        int op = rand_r(&seed) % N_OPS;
+        BigInt* a = operands[i];
+        BigInt* b = operands[j];
+
+        BigInt* res = compute(op, a, b);
+        *errors += check(res, i, j, op);
+        bigint_free(&res);
+        compute_to(op, dst, a, b);
+        *errors += check(dst, i, j, op);
+
+        *errors += bigint_hash(a) != hashes[i];
+        *errors += bigint_num_digits(a) != strlen(s_operands[i])
+                                           - (s_operands[i][0] == '-');
+        *errors += bigint_eq(a, b) != (i == j);
+    }
+    bigint_free(&dst);
+    bigint_scratch_release();
+    bigint_pool_trim();
+    return NULL;
+}
+
+void* write_copies(void* arg)
+{
+    int* errors = arg;
+    unsigned seed = (unsigned) (uintptr_t) arg;
+
+    for (int r = 0; r < STRESS_ROUNDS; r++) {
+        int i = rand_r(&seed) % N_OPERANDS;
+        BigInt* a = operands[i];
+
+        /* copies share the digits of a until written */
+        BigInt* cp = bigint_copy(a);
+        BigInt* ref = bigint_ref(a);
+        bigint_add_to(cp, cp, cp);
+        bigint_subtr_to(cp, cp, a);
+        *errors += ! bigint_eq(a, cp);
+        *errors += ! bigint_eq(a, ref);
+        bigint_free(&cp);
+        bigint_unref(&ref);
+    }
+    bigint_scratch_release();
+    bigint_pool_trim();
+    return NULL;
+}
+
+/*
+ * Runs STRESS_THREADS threads, even ones on even_fn and odd ones on
+ * odd_fn, returning their errors.
+ */
+int run_threads(void* (*even_fn)(void*), void* (*odd_fn)(void*))
+{
+    pthread_t threads[STRESS_THREADS];
+    int errors[STRESS_THREADS] = {0};
+
+    for (int t = 0; t < STRESS_THREADS; t++)
+        pthread_create(&threads[t], NULL, (t % 2) ? odd_fn : even_fn,
+                       &errors[t]);
+    int total = 0;
+    for (int t = 0; t < STRESS_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+        total += errors[t];
+    }
+    return total;
+}
+
+/* allocations of counting_malloc not freed yet, below 0 on foreign frees */
+int n_live;
+pthread_barrier_t switched;
+
+void* counting_malloc(size_t size)
+{
+    __atomic_add_fetch(&n_live, 1, __ATOMIC_RELAXED);
+    return malloc(size);
+}
+
+void* counting_realloc(void* p, size_t size)
+{
+    if (! p) __atomic_add_fetch(&n_live, 1, __ATOMIC_RELAXED);
+    return realloc(p, size);
+}
+
+void counting_free(void* p)
+{
+    if (p) __atomic_sub_fetch(&n_live, 1, __ATOMIC_RELAXED);
+    free(p);
+}
+
+/* fills the arena and pool, and uses them again once the allocator changed */
+void* compute_across_switch(void* arg)
+{
+    for (int phase = 0; phase < 2; phase++) {
+        for (int op = 0; op < N_OPS; op++) {
+            BigInt* res = compute(op, operands[3], operands[4]);
+            bigint_free(&res);
+        }
+        if (! phase) {
+            pthread_barrier_wait(&switched);
+            pthread_barrier_wait(&switched);
+        }
+    }
+    bigint_scratch_release();
+    bigint_pool_trim();
+    return NULL;
+}
+
+/** the operands still hold the values they were initialized with */
+void assert_operands()
+{
+    for (int i = 0; i < N_OPERANDS; i++) {
+        char* s = bigint_to_str(operands[i]);
+        assert_str_eq(s_operands[i], s);
+        free(s);
+    }
+}
+
+void test_shared_operands()
+{
+    compute_expected();
+    assert_int_eq(0, run_threads(read_shared, read_shared));
+    assert_operands();
+    free_expected();
+}
+
+void test_shared_copies()
+{
+    assert_int_eq(0, run_threads(write_copies, write_copies));
+    assert_operands();
+}
+
+void test_mixed()
+{
+    compute_expected();
+    assert_int_eq(0, run_threads(read_shared, write_copies));
+    assert_operands();
+    free_expected();
+}
+
+void test_allocator_switch()
+{
+    pthread_t thread;
+    pthread_barrier_init(&switched, NULL, 2);
+    pthread_create(&thread, NULL, compute_across_switch, NULL);
+
+    /* the blocks the thread cached before go back to malloc, not here */
+    pthread_barrier_wait(&switched);
+    bigint_set_allocator(counting_malloc, counting_realloc, counting_free);
+    pthread_barrier_wait(&switched);
+    pthread_join(thread, NULL);
+    assert_int_eq(0, n_live);
+
+    bigint_set_allocator(NULL, NULL, NULL);
+    pthread_barrier_destroy(&switched);
+}
+
+int main()
+{
+    run_all_tests(
+        test_shared_operands,
+        test_shared_copies,
+        test_mixed,
+        test_allocator_switch
+    );
+    return 0;
+}
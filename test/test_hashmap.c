@@ -0,0 +1,219 @@
+/**
+ * @file test_hashmap.c
+ * @brief Unit testing for the generic hashmap, keyed by BigInts.
+ *
+ * @author Vincent Mai
+ * @version 0.5.0
+ */
+
+#include "hashmap.h"
+#include "chashmap.h"
+#include "bigint/bigint.h"
+#include "sunittest/sunittest.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define N_KEYS 1000
+#define N_THREADS 8
+
+BigInt* keys[N_KEYS];
+HashMap* hmap;
+ConcurrentHashMap* cmap;
+
+int cmp_key(void* a, void* b)
+{
+    return bigint_eq(a, b);
+}
+
+/* every key in the same slot, so only probing tells them apart */
+uint32_t same_hash(void* n)
+{
+    return 7;
+}
+
+char* repr_bigint(void* n)
+{
+    return bigint_to_str(n);
+}
+
+void set_up()
+{
+    char s[32];
+    for (int i = 0; i < N_KEYS; i++) {
+        sprintf(s, "%d999999999%d", i, i);
+        keys[i] = bigint_init(s);
+    }
+    hmap = hashmap_init(0, cmp_key, bigint_hash, repr_bigint, repr_bigint);
+    cmap = chashmap_init(16, 0, cmp_key, bigint_hash,
+                         repr_bigint, repr_bigint);
+}
+
+void tear_down()
+{
+    for (int i = 0; i < N_KEYS; i++)
+        bigint_free(&keys[i]);
+    hashmap_free(&hmap);
+    chashmap_free(&cmap);
+}
+
+void test_hashmap_insert()
+{
+    for (int i = 0; i < N_KEYS; i++)
+        hashmap_insert(hmap, keys[i], keys[i]);
+    assert_int_eq(N_KEYS, hmap->count);
+    assert_true(hmap->size >= N_KEYS);
+
+    /* equal values find the entry, an insert overwrites it */
+    BigInt* key = bigint_copy(keys[42]);
+    assert_true(hashmap_get(hmap, key) == keys[42]);
+    hashmap_insert(hmap, key, keys[0]);
+    assert_true(hashmap_get(hmap, keys[42]) == keys[0]);
+    assert_int_eq(N_KEYS, hmap->count);
+
+    for (int i = 0; i < N_KEYS; i++) {
+        if (i != 42) assert_true(hashmap_get(hmap, keys[i]) == keys[i]);
+    }
+    BigInt* missing = bigint_init("-1");
+    assert_true(hashmap_get(hmap, missing) == NULL);
+    bigint_free(&key);
+    bigint_free(&missing);
+}
+
+void test_hashmap_remove()
+{
+    for (int i = 0; i < N_KEYS; i++)
+        hashmap_insert(hmap, keys[i], keys[i]);
+
+    /* the entries after a removed one are shifted back, none is lost */
+    for (int i = 0; i < N_KEYS; i += 2)
+        hashmap_remove(hmap, keys[i]);
+    assert_int_eq(N_KEYS / 2, hmap->count);
+    for (int i = 0; i < N_KEYS; i++) {
+        void* expected = (i % 2) ? keys[i] : NULL;
+        assert_true(hashmap_get(hmap, keys[i]) == expected);
+    }
+}
+
+void test_hashmap_collisions()
+{
+    HashMap* same = hashmap_init(0, cmp_key, same_hash,
+                                 repr_bigint, repr_bigint);
+    for (int i = 0; i < 100; i++)
+        hashmap_insert(same, keys[i], keys[i]);
+    for (int i = 0; i < 100; i += 3)
+        hashmap_remove(same, keys[i]);
+    for (int i = 0; i < 100; i++) {
+        void* expected = (i % 3) ? keys[i] : NULL;
+        assert_true(hashmap_get(same, keys[i]) == expected);
+    }
+    hashmap_free(&same);
+}
+
+void test_hashmap_reserve()
+{
+    hashmap_reserve(hmap, N_KEYS);
+    uint32_t size = hmap->size;
+    HashEntry* entries = hmap->entries;
+    for (int i = 0; i < N_KEYS; i++)
+        hashmap_insert(hmap, keys[i], keys[i]);
+    assert_int_eq(size, hmap->size);
+    assert_true(entries == hmap->entries);
+}
+
+void test_hashmap_clear()
+{
+    for (int i = 0; i < N_KEYS; i++)
+        hashmap_insert(hmap, keys[i], keys[i]);
+    uint32_t size = hmap->size;
+    hashmap_clear(hmap);
+    assert_int_eq(0, hmap->count);
+    assert_int_eq(size, hmap->size);
+    assert_true(hashmap_get(hmap, keys[1]) == NULL);
+
+    hashmap_insert(hmap, keys[1], keys[2]);
+    assert_true(hashmap_get(hmap, keys[1]) == keys[2]);
+}
+
+/* thread t inserts the keys i of i % N_THREADS == t - 1, reading others */
+void* insert_own(void* arg)
+{
+    int t = (int) (intptr_t) arg - 1;
+    for (int i = t; i < N_KEYS; i += N_THREADS) {
+        chashmap_insert(cmap, keys[i], keys[i]);
+        void* val = chashmap_get(cmap, keys[(i * 7) % N_KEYS]);
+        if (val && val != keys[(i * 7) % N_KEYS]) return arg;
+    }
+    return NULL;
+}
+
+/* every thread offers its own value for all keys, only one is kept */
+void* offer_all(void* arg)
+{
+    for (int i = 0; i < N_KEYS; i++) {
+        void* val = chashmap_get_or_insert(cmap, keys[i], arg);
+        if (chashmap_get(cmap, keys[i]) != val) return arg;
+    }
+    return NULL;
+}
+
+/* runs N_THREADS threads on fn, returning the number that failed */
+int run_threads(void* (*fn)(void*))
+{
+    pthread_t threads[N_THREADS];
+    for (intptr_t t = 0; t < N_THREADS; t++)
+        pthread_create(&threads[t], NULL, fn, (void*) (t + 1));
+    int failed = 0;
+    for (int t = 0; t < N_THREADS; t++) {
+        void* res;
+        pthread_join(threads[t], &res);
+        failed += res != NULL;
+    }
+    return failed;
+}
+
+void test_chashmap_insert()
+{
+    assert_int_eq(0, run_threads(insert_own));
+    assert_int_eq(N_KEYS, chashmap_count(cmap));
+    for (int i = 0; i < N_KEYS; i++)
+        assert_true(chashmap_get(cmap, keys[i]) == keys[i]);
+
+    for (int i = 0; i < N_KEYS; i += 2)
+        assert_int_eq(1, chashmap_remove(cmap, keys[i]));
+    assert_int_eq(0, chashmap_remove(cmap, keys[0]));
+    assert_int_eq(N_KEYS / 2, chashmap_count(cmap));
+    for (int i = 0; i < N_KEYS; i++) {
+        void* expected = (i % 2) ? keys[i] : NULL;
+        assert_true(chashmap_get(cmap, keys[i]) == expected);
+    }
+    chashmap_clear(cmap);
+    assert_int_eq(0, chashmap_count(cmap));
+}
+
+void test_chashmap_get_or_insert()
+{
+    assert_int_eq(0, run_threads(offer_all));
+    assert_int_eq(N_KEYS, chashmap_count(cmap));
+
+    /* the first value offered stays, later ones are handed it back */
+    void* val = chashmap_get(cmap, keys[3]);
+    assert_true(val != NULL);
+    assert_true(chashmap_get_or_insert(cmap, keys[3], keys[3]) == val);
+}
+
+int main()
+{
+    run_all_tests(
+        test_hashmap_insert,
+        test_hashmap_remove,
+        test_hashmap_collisions,
+        test_hashmap_reserve,
+        test_hashmap_clear,
+        test_chashmap_insert,
+        test_chashmap_get_or_insert
+    );
+    return 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file test_linkedlist.c
+ * @brief Unit testing for the generic linked list.
+ *
+ * @author Vincent Mai
+ * @version 0.5.0
+ */
+
+#include "linkedlist.h"
+#include "linkedlist_internal.h"
+#include "sunittest/sunittest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N_DATA 1000
+
+int data[N_DATA];
+LinkedList* list;
+
+int cmp_data(void* a, void* b)
+{
+    return *(int*) a == *(int*) b;
+}
+
+char* repr_int(void* n)
+{
+    char* s = malloc(16);
+    sprintf(s, "%d", *(int*) n);
+    return s;
+}
+
+void set_up()
+{
+    for (int i = 0; i < N_DATA; i++)
+        data[i] = i;
+    list = linkedlist_init(cmp_data, repr_int);
+}
+
+void tear_down()
+{
+    linkedlist_free(&list);
+}
+
+void test_linkedlist_push()
+{
+    for (int i = 0; i < N_DATA; i++)
+        linkedlist_push(list, &data[i]);
+
+    /* the last pushed comes first */
+    Iterator* iter = linkedlist_iter(list);
+    for (int i = N_DATA - 1; i >= 0; i--)
+        assert_true(linkedlist_next(&iter) == &data[i]);
+    assert_true(linkedlist_next(&iter) == NULL);
+
+    int missing = -1;
+    assert_true(linkedlist_has(list, &data[N_DATA / 2]));
+    assert_false(linkedlist_has(list, &missing));
+}
+
+void test_linkedlist_pop()
+{
+    for (int i = 0; i < N_DATA; i++)
+        linkedlist_push(list, &data[i]);
+    for (int i = N_DATA - 1; i >= N_DATA / 2; i--)
+        assert_true(linkedlist_pop(list) == &data[i]);
+
+    /* popped nodes take the next pushes */
+    Slab* slabs = list->store->slabs;
+    for (int i = N_DATA / 2; i < N_DATA; i++)
+        linkedlist_push(list, &data[i]);
+    assert_true(slabs == list->store->slabs);
+
+    for (int i = N_DATA - 1; i >= 0; i--)
+        assert_true(linkedlist_pop(list) == &data[i]);
+    assert_true(linkedlist_pop(list) == NULL);
+}
+
+void test_linkedlist_clear()
+{
+    for (int i = 0; i < N_DATA; i++)
+        linkedlist_push(list, &data[i]);
+    linkedlist_clear(list);
+    assert_true(linkedlist_pop(list) == NULL);
+    assert_false(linkedlist_has(list, &data[0]));
+
+    /* one slab is kept for the refill */
+    Slab* slab = list->store->slabs;
+    assert_true(slab != NULL);
+    linkedlist_push(list, &data[1]);
+    assert_true(slab == list->store->slabs);
+    assert_true(linkedlist_pop(list) == &data[1]);
+}
+
+void test_linkedlist_free()
+{
+    /* a long list is torn down without recursion */
+    for (int i = 0; i < 1000 * N_DATA; i++)
+        linkedlist_push(list, &data[i % N_DATA]);
+    linkedlist_free(&list);
+    assert_true(list == NULL);
+    list = linkedlist_init(cmp_data, repr_int);
+}
+
+int main()
+{
+    run_all_tests(
+        test_linkedlist_push,
+        test_linkedlist_pop,
+        test_linkedlist_clear,
+        test_linkedlist_free
+    );
+    return 0;
+}